@@ -0,0 +1,289 @@
+
+#include <stdio.h>
+#include <string.h>
+
+#include "params.h"
+#include "fp.h"
+
+#ifdef HAVE_FP_BACKENDS
+#include "fp_backends.h"
+#endif
+
+#if defined(HAVE_FP8) && defined(__AVX512IFMA__) && defined(__AVX512VL__)
+#include "fp8.h"
+#define BENCH_FP8
+#endif
+
+/* the backends of fp.s against each other and the lane arithmetic of fp8.h against fp.h, */
+/* then the cycles per field operation of all of them */
+
+#ifndef BENCH_ITS
+#define BENCH_ITS 100000
+#endif
+
+#define TESTS 1000
+
+static __inline__ uint64_t rdtsc(void)
+{
+    uint32_t hi, lo;
+    __asm__ __volatile__ ("rdtsc" : "=a"(lo), "=d"(hi));
+    return lo | (uint64_t) hi << 32;
+}
+
+#ifdef BENCH_FP8
+
+/* the lanes of one width against fp.h, on random elements and on 0, 1 and p - 1 */
+#define CHECK_LANES(FPV, W) \
+static int check_##FPV(void) \
+{ \
+    int failures = 0; \
+    for (int test = 0; test < TESTS; ++test) { \
+        fp a[W], b[W], r[W], expected; \
+        for (int e = 0; e < W; ++e) { \
+            fp_random(&a[e]); \
+            fp_random(&b[e]); \
+        } \
+        if (test == 0) { \
+            a[0] = fp_0; b[1] = fp_0; a[2] = fp_1; \
+            fp_sub3(&b[3], &fp_0, &fp_1); \
+            b[2] = b[3]; \
+        } \
+        \
+        FPV x, y, z; \
+        FPV##_load(&x, a); \
+        FPV##_load(&y, b); \
+        \
+        FPV##_store(r, &x); \
+        failures += memcmp(r, a, sizeof(r)) != 0; \
+        \
+        FPV##_add3(&z, &x, &y); \
+        FPV##_store(r, &z); \
+        for (int e = 0; e < W; ++e) { \
+            fp_add3(&expected, &a[e], &b[e]); \
+            failures += memcmp(&r[e], &expected, sizeof(fp)) != 0; \
+        } \
+        \
+        FPV##_sub3(&z, &x, &y); \
+        FPV##_store(r, &z); \
+        for (int e = 0; e < W; ++e) { \
+            fp_sub3(&expected, &a[e], &b[e]); \
+            failures += memcmp(&r[e], &expected, sizeof(fp)) != 0; \
+        } \
+        \
+        FPV##_mul3(&z, &x, &y); \
+        FPV##_store(r, &z); \
+        for (int e = 0; e < W; ++e) { \
+            fp_mul3(&expected, &a[e], &b[e]); \
+            failures += memcmp(&r[e], &expected, sizeof(fp)) != 0; \
+        } \
+        \
+        FPV##_sq2(&z, &x); \
+        FPV##_store(r, &z); \
+        for (int e = 0; e < W; ++e) { \
+            fp_sq2(&expected, &a[e]); \
+            failures += memcmp(&r[e], &expected, sizeof(fp)) != 0; \
+        } \
+        \
+        /* a chain of operations keeps the inputs of the next one in [0, 2p) */ \
+        z = x; \
+        fp chain[W]; \
+        memcpy(chain, a, sizeof(chain)); \
+        for (int k = 0; k < 20; ++k) { \
+            FPV##_mul3(&z, &z, &y); \
+            FPV##_sub3(&z, &z, &x); \
+            FPV##_add3(&z, &z, &z); \
+            FPV##_sq2(&z, &z); \
+            for (int e = 0; e < W; ++e) { \
+                fp_mul3(&chain[e], &chain[e], &b[e]); \
+                fp_sub3(&chain[e], &chain[e], &a[e]); \
+                fp_add3(&chain[e], &chain[e], &chain[e]); \
+                fp_sq2(&chain[e], &chain[e]); \
+            } \
+        } \
+        FPV##_store(r, &z); \
+        failures += memcmp(r, chain, sizeof(r)) != 0; \
+        \
+        uint8_t m = test & ((1 << W) - 1); \
+        z = y; \
+        FPV##_cswap(&x, &z, m); \
+        FPV##_store(r, &x); \
+        for (int e = 0; e < W; ++e) \
+            failures += memcmp(&r[e], (m >> e & 1) ? &b[e] : &a[e], sizeof(fp)) != 0; \
+        FPV##_store(r, &z); \
+        for (int e = 0; e < W; ++e) \
+            failures += memcmp(&r[e], (m >> e & 1) ? &a[e] : &b[e], sizeof(fp)) != 0; \
+        \
+        FPV##_sub3(&z, &x, &x); \
+        failures += FPV##_iszero(&z) != (1 << W) - 1; \
+        FPV##_load(&z, a); \
+        uint8_t zeros = 0; \
+        for (int e = 0; e < W; ++e) \
+            zeros |= !memcmp(&a[e], &fp_0, sizeof(fp)) << e; \
+        failures += FPV##_iszero(&z) != zeros; \
+    } \
+    printf("%-10s %s \n", #FPV, failures ? "FAIL" : "OK"); \
+    return failures; \
+}
+
+CHECK_LANES(fp8, 8)
+CHECK_LANES(fp4, 4)
+
+/* cycles per element, W elements per call */
+#define BENCH_LANES(FPV, W) \
+static void bench_##FPV(void) \
+{ \
+    fp a[W]; \
+    for (int e = 0; e < W; ++e) \
+        fp_random(&a[e]); \
+    FPV x, y; \
+    FPV##_load(&x, a); \
+    y = x; \
+    \
+    uint64_t t = rdtsc(); \
+    for (int i = 0; i < BENCH_ITS; ++i) \
+        FPV##_mul3(&x, &x, &y); \
+    uint64_t mul = rdtsc() - t; \
+    \
+    t = rdtsc(); \
+    for (int i = 0; i < BENCH_ITS; ++i) \
+        FPV##_sq2(&x, &x); \
+    uint64_t sq = rdtsc() - t; \
+    \
+    t = rdtsc(); \
+    for (int i = 0; i < BENCH_ITS; ++i) \
+        FPV##_add3(&x, &x, &y); \
+    uint64_t add = rdtsc() - t; \
+    \
+    t = rdtsc(); \
+    for (int i = 0; i < BENCH_ITS; ++i) \
+        FPV##_sub3(&x, &x, &y); \
+    uint64_t sub = rdtsc() - t; \
+    \
+    FPV##_store(a, &x); \
+    printf("%-10s %10.1f %10.1f %10.1f %10.1f \n", #FPV, \
+        (double) mul / BENCH_ITS / W, (double) sq / BENCH_ITS / W, \
+        (double) add / BENCH_ITS / W, (double) sub / BENCH_ITS / W); \
+}
+
+BENCH_LANES(fp8, 8)
+BENCH_LANES(fp4, 4)
+
+#endif
+
+#ifdef HAVE_FP_BACKENDS
+
+/* every supported backend against the last one, the original code of fp.s */
+static int check_backends(void)
+{
+    int failures = 0;
+    fp_backend const *reference = &fp_backends[fp_backend_count - 1];
+
+    /* 0, 1 and p - 1 */
+    fp edge[3] = {fp_0, {{1}}, {{0}}};
+    memcpy(&edge[2], &p, sizeof(fp));
+    edge[2].c[0] -= 1;
+
+    for (size_t b = 0; b < fp_backend_count; ++b) {
+        if (!fp_backends[b].supported())
+            continue;
+
+        int backend_failures = 0;
+        for (int test = 0; test < TESTS + 9; ++test) {
+            fp a, c, r, expected;
+            if (test < 9) {
+                a = edge[test / 3];
+                c = edge[test % 3];
+            }
+            else {
+                fp_random(&a);
+                fp_random(&c);
+            }
+
+            reference->mul3(&expected, &a, &c);
+            fp_backends[b].mul3(&r, &a, &c);
+            backend_failures += memcmp(&r, &expected, sizeof(fp)) != 0;
+
+            r = a;
+            fp_backends[b].mul3(&r, &r, &c);
+            backend_failures += memcmp(&r, &expected, sizeof(fp)) != 0;
+
+            reference->sq2(&expected, &a);
+            fp_backends[b].sq2(&r, &a);
+            backend_failures += memcmp(&r, &expected, sizeof(fp)) != 0;
+
+            r = a;
+            fp_backends[b].sq2(&r, &r);
+            backend_failures += memcmp(&r, &expected, sizeof(fp)) != 0;
+        }
+        printf("fp %-7s %s \n", fp_backends[b].name, backend_failures ? "FAIL" : "OK");
+        failures += backend_failures;
+    }
+    return failures;
+}
+
+#endif
+
+static void bench_fp(char const *name, void (*mul3)(fp *, fp const *, fp const *), void (*sq2)(fp *, fp const *))
+{
+    fp x, y;
+    fp_random(&x);
+    y = x;
+
+    uint64_t t = rdtsc();
+    for (int i = 0; i < BENCH_ITS; ++i)
+        mul3(&x, &x, &y);
+    uint64_t mul = rdtsc() - t;
+
+    t = rdtsc();
+    for (int i = 0; i < BENCH_ITS; ++i)
+        sq2(&x, &x);
+    uint64_t sq = rdtsc() - t;
+
+    t = rdtsc();
+    for (int i = 0; i < BENCH_ITS; ++i)
+        fp_add3(&x, &x, &y);
+    uint64_t add = rdtsc() - t;
+
+    t = rdtsc();
+    for (int i = 0; i < BENCH_ITS; ++i)
+        fp_sub3(&x, &x, &y);
+    uint64_t sub = rdtsc() - t;
+
+    printf("%-10s %10.1f %10.1f %10.1f %10.1f \n", name,
+        (double) mul / BENCH_ITS, (double) sq / BENCH_ITS,
+        (double) add / BENCH_ITS, (double) sub / BENCH_ITS);
+}
+
+int main(void)
+{
+    int failures = 0;
+#ifdef HAVE_FP_BACKENDS
+    printf("fp_mul3 and fp_sq2 use %s \n\n", fp_selected->name);
+    failures += check_backends();
+#endif
+#ifdef BENCH_FP8
+    failures += check_fp8() + check_fp4();
+#else
+    printf("no AVX-512 IFMA, only fp is benchmarked \n");
+#endif
+
+    printf("\ncycles per element \n");
+    printf("%-10s %10s %10s %10s %10s \n", "", "mul", "sq", "add", "sub");
+#ifdef HAVE_FP_BACKENDS
+    for (size_t b = 0; b < fp_backend_count; ++b) {
+        if (!fp_backends[b].supported())
+            continue;
+        char name[16];
+        snprintf(name, sizeof(name), "fp %s", fp_backends[b].name);
+        bench_fp(name, fp_backends[b].mul3, fp_backends[b].sq2);
+    }
+#else
+    bench_fp("fp", fp_mul3, fp_sq2);
+#endif
+#ifdef BENCH_FP8
+    bench_fp8();
+    bench_fp4();
+#endif
+
+    return failures != 0;
+}
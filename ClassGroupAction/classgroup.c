@@ -10,6 +10,55 @@
 mpz_t cn, half_cn, twopow258, babai_Ainv_row[NUM_PRIMES];
 mpf_t IP[NUM_PRIMES],B[NUM_PRIMES*NUM_PRIMES];
 
+typedef struct {
+	mpf_t IP[NUM_PRIMES];
+	mpf_t B[NUM_PRIMES*NUM_PRIMES];
+	int32_t pool[POOL_SIZE*NUM_PRIMES];
+} classgroup_tables;
+
+static classgroup_tables *node_tables[CLASSGROUP_MAX_NODES];
+
+static int first_node(void){
+	return 0;
+}
+
+int (*classgroup_node)(void) = first_node;
+
+static void free_tables(classgroup_tables *tables){
+	for(int i=0; i<NUM_PRIMES; i++){
+		mpf_clear(tables->IP[i]);
+	}
+	for(int i=0; i<NUM_PRIMES*NUM_PRIMES; i++){
+		mpf_clear(tables->B[i]);
+	}
+	free(tables);
+}
+
+// the limbs are allocated and written by the calling thread
+int classgroup_replicate(int node){
+	if (node < 0 || node >= CLASSGROUP_MAX_NODES)
+		return -1;
+
+	classgroup_tables *tables = malloc(sizeof(classgroup_tables));
+	if (tables == NULL)
+		return -1;
+
+	for(int i=0; i<NUM_PRIMES; i++){
+		mpf_init2(tables->IP[i], mpf_get_prec(IP[i]));
+		mpf_set(tables->IP[i], IP[i]);
+	}
+	for(int i=0; i<NUM_PRIMES*NUM_PRIMES; i++){
+		mpf_init2(tables->B[i], mpf_get_prec(B[i]));
+		mpf_set(tables->B[i], B[i]);
+	}
+	memcpy(tables->pool, pool, sizeof(tables->pool));
+
+	if (node_tables[node] != NULL)
+		free_tables(node_tables[node]);
+	node_tables[node] = tables;
+	return 0;
+}
+
 const char A[NUM_PRIMES*NUM_PRIMES];
 
 // clear classgroup variables
@@ -20,6 +69,13 @@ void clear_classgroup(){
 	for(int i=0; i<NUM_PRIMES; i++){
 		mpz_clear(babai_Ainv_row[i]);
 	}
+
+	classgroup_node = first_node;
+	for(int node=0; node<CLASSGROUP_MAX_NODES; node++){
+		if (node_tables[node] != NULL)
+			free_tables(node_tables[node]);
+		node_tables[node] = NULL;
+	}
 }
 
 void sample_mod_cn_with_seed(const unsigned char *seed, mpz_t a){	
@@ -95,7 +151,13 @@ int32_t L1( int8_t *vec ){
 
 // convert an integer modulo class number to a short vector modulo the relation lattice
 void mod_cn_2_vec(mpz_t a, int8_t *vec){
-	
+	// the tables of the node of the calling thread
+	int node = classgroup_node();
+	classgroup_tables *tables = (node >= 0 && node < CLASSGROUP_MAX_NODES) ? node_tables[node] : NULL;
+	mpf_t *basis = (tables != NULL) ? tables->B : B;
+	mpf_t *inner_products = (tables != NULL) ? tables->IP : IP;
+	int32_t *vectors = (tables != NULL) ? tables->pool : pool;
+
 	// initialize target
 	mpz_t target[NUM_PRIMES];
 	for(int i=0; i<NUM_PRIMES; i++){
@@ -106,8 +168,8 @@ void mod_cn_2_vec(mpz_t a, int8_t *vec){
 	// babai nearest plane
 	for(int i=NUM_PRIMES-1 ; i>=0 ; i--){
 		mpf_t ip1,floor;
-		inner_product(target,B + i*74 ,ip1);
-		mpf_div(ip1,ip1,IP[i]);
+		inner_product(target,basis + i*74 ,ip1);
+		mpf_div(ip1,ip1,inner_products[i]);
 
 		mpf_init(floor);
 		mpf_floor(floor,ip1);
@@ -140,7 +202,7 @@ void mod_cn_2_vec(mpz_t a, int8_t *vec){
 	//int norm = L1(vec);
 
 	// reduce with pool of small vectors
-	reduce(vec,2,10000);
+	reduce(vec,2,10000,vectors);
 
 	//printf("norm before reduction %d \n"  , norm );
 	//printf("norm after  reduction %d \n"  , L1(vec));
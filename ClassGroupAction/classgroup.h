@@ -12,6 +12,13 @@ extern mpz_t cn;
 void init_classgroup();
 void clear_classgroup();
 
+// the Babai basis, its inner products and the pool of reduce can be copied to up to CLASSGROUP_MAX_NODES NUMA nodes.
+// classgroup_replicate(node) makes the copy of a node and should run on that node, so that the copy ends up in its memory.
+// mod_cn_2_vec uses the copy of the node that classgroup_node returns, or the originals if that node has no copy
+#define CLASSGROUP_MAX_NODES 16
+extern int (*classgroup_node)(void);
+int classgroup_replicate(int node);
+
 void sample_mod_cn(mpz_t a);
 void mod_cn_2_vec(mpz_t a, int8_t *vec);
 void sample_from_classgroup(int8_t *vec);
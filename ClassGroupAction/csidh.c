@@ -7,6 +7,7 @@
 
 #include "uint.h"
 #include "fp.h"
+#include "fpx.h"
 #include "mont.h"
 #include "csidh.h"
 #include "rng.h"
@@ -18,6 +19,11 @@
 
 const public_key base = {{{0}}}; /* A = 0 */
 
+#ifdef ACTION_MULTI_STATS
+/* the steps of action_lanes that a lane could not take because its kernel point was at infinity */
+uint64_t action_multi_infinity = 0;
+#endif
+
 #ifdef UNIFORM
 void csidh_private(private_key *priv)
 {
@@ -268,6 +274,170 @@ void action(public_key *out, public_key const *in, private_key const *priv)
 
 }
 
+static lane_mask lanes_with_steps(uint8_t e[FPX_LANES][2][NUM_PRIMES], size_t n)
+{
+    lane_mask active = 0;
+    for (size_t l = 0; l < n; ++l)
+        for (size_t i = 0; i < NUM_PRIMES; ++i)
+            if (e[l][0][i] || e[l][1][i])
+                active |= (lane_mask) 1 << l;
+    return active;
+}
+
+/* FPX_LANES curves in lockstep, all of them walk the primes that one of them still needs in the direction of the round. */
+/* a lane that does not need the prime, or whose kernel point is at infinity, multiplies its point by the prime instead. */
+/* lanes from n on are padding, they take no steps. */
+static void action_lanes(public_key *out, public_key const *in, size_t n, private_key const *priv)
+{
+    uint8_t e[FPX_LANES][2][NUM_PRIMES] = {{{0}}};
+    fp A_affine[FPX_LANES];
+
+    for (size_t l = 0; l < FPX_LANES; ++l) {
+        A_affine[l] = in[l < n ? l : 0].A;
+        if (l >= n)
+            continue;
+        for (size_t i = 0; i < NUM_PRIMES; ++i) {
+            int8_t t = (int8_t) priv->e[i];
+            e[l][0][i] = t > 0 ? t : 0;
+            e[l][1][i] = t < 0 ? -t : 0;
+        }
+    }
+
+    lane_mask active = lanes_with_steps(e, n);
+    bool sign = false;
+
+    /* the last lane with steps left does not need the others */
+    while (__builtin_popcount(active) >= 2) {
+
+        bool need[NUM_PRIMES];
+        bool any = false;
+        uint k;
+        uint_set(&k, 4); /* maximal 2-power in p+1 */
+        for (size_t i = 0; i < NUM_PRIMES; ++i) {
+            need[i] = false;
+            for (size_t l = 0; l < n; ++l)
+                need[i] |= e[l][sign][i] != 0;
+            if (need[i])
+                any = true;
+            else
+                uint_mul3_64(&k, &k, primes[i]);
+        }
+
+        if (!any) {
+            sign = !sign;
+            continue;
+        }
+
+        /* a random point of the direction of the round on every curve */
+        projx A, P;
+        fp x[FPX_LANES];
+        for (unsigned l = 0; l < FPX_LANES; ++l) {
+            fp rhs;
+            do {
+                fp_random(&x[l]);
+                montgomery_rhs(&rhs, &A_affine[l], &x[l]);
+            } while (!fp_issquare(&rhs) != sign);
+        }
+        fpx_load(&A.x, A_affine);
+        fpx_load(&P.x, x);
+        fpx_set(&A.z, &fp_1);
+        fpx_set(&P.z, &fp_1);
+
+        xMUL_multi(&P, &A, &P, &k);
+
+        for (size_t i = NUM_PRIMES - 1; i < NUM_PRIMES; --i) {
+
+            if (!need[i])
+                continue;
+
+            uint cof = uint_1;
+            for (size_t j = 0; j < i; ++j)
+                if (need[j])
+                    uint_mul3_64(&cof, &cof, primes[j]);
+
+            projx K;
+            xMUL_multi(&K, &A, &P, &cof);
+
+            lane_mask step = 0;
+            for (unsigned l = 0; l < n; ++l)
+                if (e[l][sign][i])
+                    step |= (lane_mask) 1 << l;
+#ifdef ACTION_MULTI_STATS
+            action_multi_infinity += __builtin_popcount(step & fpx_iszero(&K.z));
+#endif
+            step &= ~fpx_iszero(&K.z);
+            lane_mask skip = ALL_LANES & ~step;
+
+            projx P_skip;
+            if (skip) {
+                uint l_i;
+                uint_set(&l_i, primes[i]);
+                xMUL_multi(&P_skip, &A, &P, &l_i);
+            }
+
+            if (step) {
+                projx A_step = A, P_step = P;
+                xISOG_multi(&A_step, &P_step, &K, primes[i]);
+                fpx_select(&A.x, &A_step.x, step);
+                fpx_select(&A.z, &A_step.z, step);
+                fpx_select(&P.x, &P_step.x, step);
+                fpx_select(&P.z, &P_step.z, step);
+            }
+
+            if (skip) {
+                fpx_select(&P.x, &P_skip.x, skip);
+                fpx_select(&P.z, &P_skip.z, skip);
+            }
+
+            for (unsigned l = 0; l < n; ++l)
+                if (step >> l & 1)
+                    --e[l][sign][i];
+        }
+
+        fp z[FPX_LANES];
+        fpx_store(A_affine, &A.x);
+        fpx_store(z, &A.z);
+        for (unsigned l = 0; l < FPX_LANES; ++l) {
+            fp_inv(&z[l]);
+            fp_mul2(&A_affine[l], &z[l]);
+        }
+
+        active = lanes_with_steps(e, n);
+        sign = !sign;
+    }
+
+    for (unsigned l = 0; l < n; ++l) {
+        out[l].A = A_affine[l];
+        if (active >> l & 1) {
+            private_key rest;
+            for (size_t i = 0; i < NUM_PRIMES; ++i)
+                rest.e[i] = (int8_t) e[l][0][i] - (int8_t) e[l][1][i];
+            action(&out[l], &out[l], &rest);
+        }
+    }
+}
+
+/* the fewest curves for which a group in lockstep is cheaper than action on each of them */
+/* with vectorized lanes a group costs about as much as 2 to 3 calls of action, whatever the number of curves */
+#if FPX_VECTORIZED
+#define ACTION_MULTI_MIN 3
+#else
+#define ACTION_MULTI_MIN FPX_LANES
+#endif
+
+/* the same as action on each of the n curves */
+void action_multi(public_key *out, public_key const *in, size_t n, private_key const *priv)
+{
+    for (size_t j = 0; j < n; j += FPX_LANES) {
+        size_t lanes = n - j < FPX_LANES ? n - j : FPX_LANES;
+        if (lanes >= ACTION_MULTI_MIN)
+            action_lanes(out + j, in + j, lanes, priv);
+        else
+            for (size_t l = 0; l < lanes; ++l)
+                action(&out[j + l], &in[j + l], priv);
+    }
+}
+
 void mpz_action(public_key *out, public_key const *in, mpz_t a){
     private_key pk;
     mod_cn_2_vec(a, pk.e);
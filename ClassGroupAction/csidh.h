@@ -2,6 +2,7 @@
 #define CSIDH_H
 
 #include <stdbool.h>
+#include <stddef.h>
 
 #include "gmp.h"
 #include "params.h"
@@ -15,10 +16,15 @@ typedef struct public_key {
 } public_key;
 
 extern const public_key base;
+#ifdef ACTION_MULTI_STATS
+extern uint64_t action_multi_infinity;
+#endif
 
 void csidh_private(private_key *priv);
 bool csidh(public_key *out, public_key const *in, private_key const *priv);
 void action(public_key *out, public_key const *in, private_key const *priv);
+void action_multi(public_key *out, public_key const *in, size_t n, private_key const *priv);
+bool validate(public_key const *in);
 
 
 void mpz_action(public_key *out, public_key const *in, mpz_t a);
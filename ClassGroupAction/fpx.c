@@ -0,0 +1,89 @@
+
+#include <string.h>
+
+#include "params.h"
+#include "fp.h"
+#include "fpx.h"
+
+#if FPX_VECTORIZED
+
+#if FPX_LANES == 8
+#define FPV(name) fp8_##name
+#else
+#define FPV(name) fp4_##name
+#endif
+
+void fpx_load(fpx *x, fp const y[FPX_LANES]) { FPV(load)(&x->v, y); }
+void fpx_store(fp y[FPX_LANES], fpx const *x) { FPV(store)(y, &x->v); }
+void fpx_set(fpx *x, fp const *y) { FPV(set)(&x->v, y); }
+void fpx_select(fpx *x, fpx const *y, lane_mask m) { FPV(select)(&x->v, &y->v, m); }
+lane_mask fpx_iszero(fpx const *x) { return FPV(iszero)(&x->v); }
+
+void fpx_add3(fpx *x, fpx const *y, fpx const *z) { FPV(add3)(&x->v, &y->v, &z->v); }
+void fpx_sub3(fpx *x, fpx const *y, fpx const *z) { FPV(sub3)(&x->v, &y->v, &z->v); }
+void fpx_mul3(fpx *x, fpx const *y, fpx const *z) { FPV(mul3)(&x->v, &y->v, &z->v); }
+void fpx_sq2(fpx *x, fpx const *y) { FPV(sq2)(&x->v, &y->v); }
+
+#else
+
+/* one lane after the other with the scalar field arithmetic */
+
+void fpx_load(fpx *x, fp const y[FPX_LANES])
+{
+    for (unsigned l = 0; l < FPX_LANES; ++l)
+        x->lane[l] = y[l];
+}
+
+void fpx_store(fp y[FPX_LANES], fpx const *x)
+{
+    for (unsigned l = 0; l < FPX_LANES; ++l)
+        y[l] = x->lane[l];
+}
+
+void fpx_set(fpx *x, fp const *y)
+{
+    for (unsigned l = 0; l < FPX_LANES; ++l)
+        x->lane[l] = *y;
+}
+
+void fpx_select(fpx *x, fpx const *y, lane_mask m)
+{
+    for (unsigned l = 0; l < FPX_LANES; ++l)
+        if (m >> l & 1)
+            x->lane[l] = y->lane[l];
+}
+
+lane_mask fpx_iszero(fpx const *x)
+{
+    lane_mask m = 0;
+    for (unsigned l = 0; l < FPX_LANES; ++l)
+        if (!memcmp(&x->lane[l], &fp_0, sizeof(fp)))
+            m |= (lane_mask) 1 << l;
+    return m;
+}
+
+void fpx_add3(fpx *x, fpx const *y, fpx const *z)
+{
+    for (unsigned l = 0; l < FPX_LANES; ++l)
+        fp_add3(&x->lane[l], &y->lane[l], &z->lane[l]);
+}
+
+void fpx_sub3(fpx *x, fpx const *y, fpx const *z)
+{
+    for (unsigned l = 0; l < FPX_LANES; ++l)
+        fp_sub3(&x->lane[l], &y->lane[l], &z->lane[l]);
+}
+
+void fpx_mul3(fpx *x, fpx const *y, fpx const *z)
+{
+    for (unsigned l = 0; l < FPX_LANES; ++l)
+        fp_mul3(&x->lane[l], &y->lane[l], &z->lane[l]);
+}
+
+void fpx_sq2(fpx *x, fpx const *y)
+{
+    for (unsigned l = 0; l < FPX_LANES; ++l)
+        fp_sq2(&x->lane[l], &y->lane[l]);
+}
+
+#endif
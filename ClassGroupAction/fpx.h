@@ -0,0 +1,58 @@
+#ifndef FPX_H
+#define FPX_H
+
+#include <stdbool.h>
+
+#include "params.h"
+
+/* FPX_LANES field elements that go through the same sequence of operations. */
+/* the layout is up to the implementation, lanes are moved in and out with fpx_load and fpx_store. */
+
+#ifndef FPX_LANES
+#define FPX_LANES 8
+#endif
+
+typedef uint32_t lane_mask; /* bit l stands for lane l */
+#define ALL_LANES ((lane_mask) ((1ull << FPX_LANES) - 1))
+
+#if defined(HAVE_FP8) && !defined(FPX_GENERIC) && defined(__AVX512IFMA__) && defined(__AVX512VL__) && (FPX_LANES == 8 || FPX_LANES == 4)
+
+#include "fp8.h"
+
+/* the lanes are the vector lanes of fp8.h (fp4.h for 4 lanes) */
+#define FPX_VECTORIZED 1
+
+#if FPX_LANES == 8
+typedef struct fpx { fp8 v; } fpx;
+#else
+typedef struct fpx { fp4 v; } fpx;
+#endif
+
+#else
+
+/* the lanes go one after the other, so lanes that are only padding cost as much as real ones */
+#define FPX_VECTORIZED 0
+
+typedef struct fpx { fp lane[FPX_LANES]; } fpx;
+
+#endif
+
+typedef struct projx { fpx x, z; } projx;
+
+void fpx_load(fpx *x, fp const y[FPX_LANES]);
+void fpx_store(fp y[FPX_LANES], fpx const *x);
+void fpx_set(fpx *x, fp const *y); /* y in every lane */
+void fpx_select(fpx *x, fpx const *y, lane_mask m); /* x := y in the lanes of m */
+lane_mask fpx_iszero(fpx const *x);
+
+void fpx_add3(fpx *x, fpx const *y, fpx const *z);
+void fpx_sub3(fpx *x, fpx const *y, fpx const *z);
+void fpx_mul3(fpx *x, fpx const *y, fpx const *z);
+void fpx_sq2(fpx *x, fpx const *y);
+
+static inline void fpx_add2(fpx *x, fpx const *y) { fpx_add3(x, x, y); }
+static inline void fpx_sub2(fpx *x, fpx const *y) { fpx_sub3(x, x, y); }
+static inline void fpx_mul2(fpx *x, fpx const *y) { fpx_mul3(x, x, y); }
+static inline void fpx_sq1(fpx *x) { fpx_sq2(x, x); }
+
+#endif
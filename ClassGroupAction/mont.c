@@ -6,6 +6,7 @@
 #include "params.h"
 #include "uint.h"
 #include "fp.h"
+#include "fpx.h"
 #include "mont.h"
 
 void xDBLADD(proj *R, proj *S, proj const *P, proj const *Q, proj const *PQ, proj const *A)
@@ -308,3 +309,177 @@ int myxISOG(proj *A, proj *P, int points, proj const *K, uint64_t k, int check)
     return check;
 }
 
+
+/* the same formulas on FPX_LANES curves and points at once */
+
+void xDBLADD_multi(projx *R, projx *S, projx const *P, projx const *Q, projx const *PQ, projx const *A)
+{
+    fpx a, b, c, d;
+
+    fpx_add3(&a, &Q->x, &Q->z);
+    fpx_sub3(&b, &Q->x, &Q->z);
+    fpx_add3(&c, &P->x, &P->z);
+    fpx_sub3(&d, &P->x, &P->z);
+    fpx_sq2(&R->x, &c);
+    fpx_sq2(&S->x, &d);
+    fpx_mul2(&c, &b);
+    fpx_mul2(&d, &a);
+    fpx_sub3(&b, &R->x, &S->x);
+    fpx_add3(&a, &A->z, &A->z); /* multiplication by 2 */
+    fpx_mul3(&R->z, &a, &S->x);
+    fpx_add3(&S->x, &A->x, &a);
+    fpx_add2(&R->z, &R->z); /* multiplication by 2 */
+    fpx_mul2(&R->x, &R->z);
+    fpx_mul2(&S->x, &b);
+    fpx_sub3(&S->z, &c, &d);
+    fpx_add2(&R->z, &S->x);
+    fpx_add3(&S->x, &c, &d);
+    fpx_mul2(&R->z, &b);
+    fpx_sq2(&d, &S->z);
+    fpx_sq2(&b, &S->x);
+    fpx_mul3(&S->x, &PQ->z, &b);
+    fpx_mul3(&S->z, &PQ->x, &d);
+}
+
+void xDBL_multi(projx *Q, projx const *A, projx const *P)
+{
+    fpx a, b, c;
+    fpx_add3(&a, &P->x, &P->z);
+    fpx_sq1(&a);
+    fpx_sub3(&b, &P->x, &P->z);
+    fpx_sq1(&b);
+    fpx_sub3(&c, &a, &b);
+    fpx_add2(&b, &b); fpx_add2(&b, &b); /* multiplication by 4 */
+    fpx_mul2(&b, &A->z);
+    fpx_mul3(&Q->x, &a, &b);
+    fpx_add3(&a, &A->z, &A->z); /* multiplication by 2 */
+    fpx_add2(&a, &A->x);
+    fpx_mul2(&a, &c);
+    fpx_add2(&a, &b);
+    fpx_mul3(&Q->z, &a, &c);
+}
+
+void xADD_multi(projx *S, projx const *P, projx const *Q, projx const *PQ)
+{
+    fpx a, b, c, d;
+    fpx_add3(&a, &P->x, &P->z);
+    fpx_sub3(&b, &P->x, &P->z);
+    fpx_add3(&c, &Q->x, &Q->z);
+    fpx_sub3(&d, &Q->x, &Q->z);
+    fpx_mul2(&a, &d);
+    fpx_mul2(&b, &c);
+    fpx_add3(&c, &a, &b);
+    fpx_sub3(&d, &a, &b);
+    fpx_sq1(&c);
+    fpx_sq1(&d);
+    fpx_mul3(&S->x, &PQ->z, &c);
+    fpx_mul3(&S->z, &PQ->x, &d);
+}
+
+/* Montgomery ladder, the same scalar for every lane. */
+void xMUL_multi(projx *Q, projx const *A, projx const *P, uint const *k)
+{
+    projx R = *P;
+    const projx Pcopy = *P; /* in case Q = P */
+
+    fpx_set(&Q->x, &fp_1);
+    fpx_set(&Q->z, &fp_0);
+
+    unsigned long i = 64 * LIMBS;
+    while (--i && !uint_bit(k, i));
+
+    do {
+
+        bool bit = uint_bit(k, i);
+
+        if (bit) { projx T = *Q; *Q = R; R = T; }
+
+        xDBLADD_multi(Q, &R, Q, &R, &Pcopy, A);
+
+        if (bit) { projx T = *Q; *Q = R; R = T; }
+
+    } while (i--);
+}
+
+/* xISOG of the same degree k on every lane, without the kernel check */
+void xISOG_multi(projx *A, projx *P, projx const *K, uint64_t k)
+{
+    assert (k >= 3);
+    assert (k % 2 == 1);
+
+    fpx tmp0, tmp1;
+    fpx T[4] = {K->z, K->x, K->x, K->z};
+    projx Q;
+
+    fpx_mul3(&Q.x,  &P->x, &K->x);
+    fpx_mul3(&tmp0, &P->z, &K->z);
+    fpx_sub2(&Q.x,  &tmp0);
+
+    fpx_mul3(&Q.z,  &P->x, &K->z);
+    fpx_mul3(&tmp0, &P->z, &K->x);
+    fpx_sub2(&Q.z,  &tmp0);
+
+    projx M[3] = {*K};
+    xDBL_multi(&M[1], A, K);
+
+    for (uint64_t i = 1; i < k / 2; ++i) {
+
+        if (i >= 2)
+            xADD_multi(&M[i % 3], &M[(i - 1) % 3], K, &M[(i - 2) % 3]);
+
+        fpx_mul3(&tmp0, &M[i % 3].x, &T[0]);
+        fpx_mul3(&tmp1, &M[i % 3].z, &T[1]);
+        fpx_add3(&T[0], &tmp0, &tmp1);
+
+        fpx_mul2(&T[1], &M[i % 3].x);
+
+        fpx_mul3(&tmp0, &M[i % 3].z, &T[2]);
+        fpx_mul3(&tmp1, &M[i % 3].x, &T[3]);
+        fpx_add3(&T[2], &tmp0, &tmp1);
+
+        fpx_mul2(&T[3], &M[i % 3].z);
+
+
+        fpx_mul3(&tmp0, &P->x, &M[i % 3].x);
+        fpx_mul3(&tmp1, &P->z, &M[i % 3].z);
+        fpx_sub2(&tmp0, &tmp1);
+        fpx_mul2(&Q.x,  &tmp0);
+
+        fpx_mul3(&tmp0, &P->x, &M[i % 3].z);
+        fpx_mul3(&tmp1, &P->z, &M[i % 3].x);
+        fpx_sub2(&tmp0, &tmp1);
+        fpx_mul2(&Q.z,  &tmp0);
+    }
+
+    fpx_mul2(&T[0], &T[1]);
+    fpx_add2(&T[0], &T[0]); /* multiplication by 2 */
+
+    fpx_sq1(&T[1]);
+
+    fpx_mul2(&T[2], &T[3]);
+    fpx_add2(&T[2], &T[2]); /* multiplication by 2 */
+
+    fpx_sq1(&T[3]);
+
+    /* Ax := T[1] * T[3] * Ax - 3 * Az * (T[1] * T[2] - T[0] * T[3]) */
+    fpx_mul3(&tmp0, &T[1], &T[2]);
+    fpx_mul3(&tmp1, &T[0], &T[3]);
+    fpx_sub2(&tmp0, &tmp1);
+    fpx_mul2(&tmp0, &A->z);
+    fpx_add3(&tmp1, &tmp0, &tmp0); fpx_add2(&tmp0, &tmp1); /* multiplication by 3 */
+
+    fpx_mul3(&tmp1, &T[1], &T[3]);
+    fpx_mul2(&tmp1, &A->x);
+
+    fpx_sub3(&A->x, &tmp1, &tmp0);
+
+    /* Az := Az * T[3]^2 */
+    fpx_sq1(&T[3]);
+    fpx_mul2(&A->z, &T[3]);
+
+    /* X := X * Xim^2, Z := Z * Zim^2 */
+    fpx_sq1(&Q.x);
+    fpx_sq1(&Q.z);
+    fpx_mul2(&P->x, &Q.x);
+    fpx_mul2(&P->z, &Q.z);
+}
@@ -2,6 +2,7 @@
 #define MONT_H
 
 #include "params.h"
+#include "fpx.h"
 
 void xDBL(proj *Q, proj const *A, proj const *P);
 void xADD(proj *S, proj const *P, proj const *Q, proj const *PQ);
@@ -10,4 +11,11 @@ void xMUL(proj *Q, proj const *A, proj const *P, uint const *k);
 int xISOG(proj *A, proj *P, proj const *K, uint64_t k, int check);
 int myxISOG(proj *A, proj *P, int points, proj const *K, uint64_t k, int check);
 
+/* FPX_LANES curves and points in lockstep */
+void xDBL_multi(projx *Q, projx const *A, projx const *P);
+void xADD_multi(projx *S, projx const *P, projx const *Q, projx const *PQ);
+void xDBLADD_multi(projx *R, projx *S, projx const *P, projx const *Q, projx const *PQ, projx const *A);
+void xMUL_multi(projx *Q, projx const *A, projx const *P, uint const *k);
+void xISOG_multi(projx *A, projx *P, projx const *K, uint64_t k);
+
 #endif
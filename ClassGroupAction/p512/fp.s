@@ -145,8 +145,13 @@ fp_dec:
     lea rdx, [rip + uint_1]
     jmp fp_mul3
 
+/* the Montgomery multiplication and squaring that fp_select.c picked for the CPU */
 .global fp_mul3
 fp_mul3:
+    jmp [rip + fp_mul3_impl]
+
+.global fp_mul3_default
+fp_mul3_default:
     push rbp
     push rbx
     push r12
@@ -292,9 +297,12 @@ fp_mul2:
 
 .global fp_sq2
 fp_sq2:
-    /* TODO implement optimized Montgomery squaring */
+    jmp [rip + fp_sq2_impl]
+
+.global fp_sq2_default
+fp_sq2_default:
     mov rdx, rsi
-    jmp fp_mul3
+    jmp fp_mul3_default
 
 .global fp_sq1
 fp_sq1:
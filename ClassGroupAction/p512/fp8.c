@@ -0,0 +1,116 @@
+
+#include "fp8.h"
+
+#if defined(__AVX512IFMA__) && defined(__AVX512VL__)
+
+#define MASK52 (((uint64_t) 1 << 52) - 1)
+
+/* p, 2p, -p^-1 mod 2^52 and the constants that move between R = 2^512 and R = 2^520 */
+
+static const uint64_t p52[FP8_LIMBS] = {
+    0x1b90533c6c87b, 0xf457aca8351b8, 0xf0b4f25c2721b, 0x5507516730cc1, 0xda7aac6c567f3,
+    0xfbfcc69322c9c, 0x83aedc88c425a, 0x5e3e4c4ab42d0, 0xf89bffc8ab0d1, 0x0065b48e8f740,
+};
+
+static const uint64_t twice_p52[FP8_LIMBS] = {
+    0x3720a678d90f6, 0xe8af59506a370, 0xe169e4b84e437, 0xaa0ea2ce61983, 0xb4f558d8acfe6,
+    0xf7f98d2645939, 0x075db911884b5, 0xbc7c9895685a1, 0xf137ff91561a2, 0x00cb691d1ee81,
+};
+
+static const uint64_t inv_min_p_mod_2_52 = 0x1301f632e294d;
+
+/* 2^528 mod p */
+static const uint64_t to_r520[FP8_LIMBS] = {
+    0xb40d1b8e62e5b, 0xc51fc7fb18756, 0x7b2a3d5c954f3, 0x098133f366280, 0x52b97a33e4acd,
+    0x99a82be26dc2e, 0x3f541bd067e54, 0x4ef5c305da95b, 0x4ea7463b9b139, 0x000b5e38ccd7b,
+};
+
+/* 2^512 mod p */
+static const uint64_t to_r512[FP8_LIMBS] = {
+    0xc8df598726f0a, 0x1750a6af95c8f, 0x1e961b47b1bc8, 0x55f15d319e67c, 0x4b0aa72753019,
+    0x080672d9ba6c6, 0xf8a246ee77b4a, 0x4383676a97a5e, 0x0ec8006ea9e5d, 0x003496e2e117e,
+};
+
+static uint64_t limb52(fp const *x, unsigned i)
+{
+    unsigned word = 52 * i / 64, shift = 52 * i % 64;
+    uint64_t v = x->c[word] >> shift;
+    if (shift > 12 && word + 1 < LIMBS)
+        v |= x->c[word + 1] << (64 - shift);
+    return v & MASK52;
+}
+
+static void from_limbs52(fp *x, uint64_t const l[FP8_LIMBS])
+{
+    for (unsigned w = 0; w < LIMBS; ++w)
+        x->c[w] = 0;
+    for (unsigned i = 0; i < FP8_LIMBS; ++i) {
+        unsigned word = 52 * i / 64, shift = 52 * i % 64;
+        x->c[word] |= l[i] << shift;
+        if (shift > 12 && word + 1 < LIMBS)
+            x->c[word + 1] |= l[i] >> (64 - shift);
+    }
+}
+
+#define FPV fp8
+#define FPV_LANES 8
+#define VEC __m512i
+#define F(name) fp8_##name
+#define SET1 _mm512_set1_epi64
+#define ZERO _mm512_setzero_si512
+#define ADD _mm512_add_epi64
+#define SUB _mm512_sub_epi64
+#define AND _mm512_and_si512
+#define OR _mm512_or_si512
+#define XOR _mm512_xor_si512
+#define SRLI _mm512_srli_epi64
+#define SRAI _mm512_srai_epi64
+#define MADDLO _mm512_madd52lo_epu64
+#define MADDHI _mm512_madd52hi_epu64
+#define BLEND _mm512_mask_blend_epi64
+#define ISZERO(v) _mm512_cmpeq_epi64_mask(v, ZERO())
+#define LOADU(a) _mm512_loadu_si512((void const *) (a))
+#define STOREU(a, v) _mm512_storeu_si512((void *) (a), v)
+#include "fp8.inc"
+#undef FPV
+#undef FPV_LANES
+#undef VEC
+#undef F
+#undef SET1
+#undef ZERO
+#undef ADD
+#undef SUB
+#undef AND
+#undef OR
+#undef XOR
+#undef SRLI
+#undef SRAI
+#undef MADDLO
+#undef MADDHI
+#undef BLEND
+#undef ISZERO
+#undef LOADU
+#undef STOREU
+
+#define FPV fp4
+#define FPV_LANES 4
+#define VEC __m256i
+#define F(name) fp4_##name
+#define SET1 _mm256_set1_epi64x
+#define ZERO _mm256_setzero_si256
+#define ADD _mm256_add_epi64
+#define SUB _mm256_sub_epi64
+#define AND _mm256_and_si256
+#define OR _mm256_or_si256
+#define XOR _mm256_xor_si256
+#define SRLI _mm256_srli_epi64
+#define SRAI _mm256_srai_epi64
+#define MADDLO _mm256_madd52lo_epu64
+#define MADDHI _mm256_madd52hi_epu64
+#define BLEND _mm256_mask_blend_epi64
+#define ISZERO(v) _mm256_cmpeq_epi64_mask(v, ZERO())
+#define LOADU(a) _mm256_loadu_si256((void const *) (a))
+#define STOREU(a, v) _mm256_storeu_si256((void *) (a), v)
+#include "fp8.inc"
+
+#endif
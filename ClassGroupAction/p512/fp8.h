@@ -0,0 +1,41 @@
+#ifndef FP8_H
+#define FP8_H
+
+#include <immintrin.h>
+#include <stdbool.h>
+
+#include "params.h"
+
+/* 8 (fp8) or 4 (fp4) elements of fp side by side, for AVX-512 IFMA. */
+/* vector i holds limb i of every element, an element is sum_i l[i] 2^(52 i). */
+/* the elements are in Montgomery form with R = 2^520 and in [0, 2p), every limb is below 2^52. */
+/* the lanes of a mask are the elements whose bit is set. */
+
+#define FP8_LIMBS 10
+
+typedef struct fp8 { __m512i l[FP8_LIMBS]; } fp8;
+typedef struct fp4 { __m256i l[FP8_LIMBS]; } fp4;
+
+void fp8_load(fp8 *x, fp const y[8]); /* from the Montgomery form of fp.h */
+void fp8_store(fp y[8], fp8 const *x);
+void fp8_set(fp8 *x, fp const *y); /* y in every lane */
+void fp8_add3(fp8 *x, fp8 const *y, fp8 const *z);
+void fp8_sub3(fp8 *x, fp8 const *y, fp8 const *z);
+void fp8_mul3(fp8 *x, fp8 const *y, fp8 const *z);
+void fp8_sq2(fp8 *x, fp8 const *y);
+void fp8_cswap(fp8 *x, fp8 *y, uint8_t m);
+void fp8_select(fp8 *x, fp8 const *y, uint8_t m); /* x := y in the lanes of m */
+uint8_t fp8_iszero(fp8 const *x);
+
+void fp4_load(fp4 *x, fp const y[4]);
+void fp4_store(fp y[4], fp4 const *x);
+void fp4_set(fp4 *x, fp const *y);
+void fp4_add3(fp4 *x, fp4 const *y, fp4 const *z);
+void fp4_sub3(fp4 *x, fp4 const *y, fp4 const *z);
+void fp4_mul3(fp4 *x, fp4 const *y, fp4 const *z);
+void fp4_sq2(fp4 *x, fp4 const *y);
+void fp4_cswap(fp4 *x, fp4 *y, uint8_t m);
+void fp4_select(fp4 *x, fp4 const *y, uint8_t m);
+uint8_t fp4_iszero(fp4 const *x);
+
+#endif
@@ -0,0 +1,23 @@
+#ifndef FP_BACKENDS_H
+#define FP_BACKENDS_H
+
+#include <stddef.h>
+
+#include "params.h"
+
+/* implementations of fp_mul3 and fp_sq2, fp_select.c picks one when the program is loaded */
+typedef struct fp_backend {
+    const char *name;
+    int (*supported)(void);
+    void (*mul3)(fp *x, fp const *y, fp const *z);
+    void (*sq2)(fp *x, fp const *y);
+} fp_backend;
+
+/* fastest first */
+extern const fp_backend fp_backends[];
+extern const size_t fp_backend_count;
+
+/* FP_BACKEND in the environment picks another supported backend by name */
+extern const fp_backend *fp_selected;
+
+#endif
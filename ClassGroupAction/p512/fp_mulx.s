@@ -0,0 +1,321 @@
+
+.intel_syntax noprefix
+
+.section .text
+
+/* Montgomery multiplication and squaring with MULX/ADCX/ADOX, picked by fp_select.c. */
+/* every step adds a row of products and then m p, so the reduction of a word sees the whole row. */
+/* the result stays in registers until it is below p. */
+
+/* lo += low half of rdx * src, hi += high half, on the OF and CF chains */
+.macro PROD, src, lo, hi
+    mulx rcx, rax, \src
+    adox \lo, rax
+    adcx \hi, rcx
+.endm
+
+/* r0..r8 += rdx * y, y at [rsi] */
+.macro MULROW, r0, r1, r2, r3, r4, r5, r6, r7, r8
+    xor rax, rax /* clear flags */
+    PROD [rsi +  0], \r0, \r1
+    PROD [rsi +  8], \r1, \r2
+    PROD [rsi + 16], \r2, \r3
+    PROD [rsi + 24], \r3, \r4
+    PROD [rsi + 32], \r4, \r5
+    PROD [rsi + 40], \r5, \r6
+    PROD [rsi + 48], \r6, \r7
+    PROD [rsi + 56], \r7, \r8
+    mov rax, 0
+    adox \r8, rax
+.endm
+
+/* row k of a square: a_k * (a_k + 2 (a >> 64 (k+1)) 2^64) from word k on */
+/* a is at [rsi], rdx = a_k. 2 a is at [rsp], except that word k+1 must not take the top bit of a_k, */
+/* so that word comes from a_{k+1} << 1 at [rsp + 64] */
+.macro SQRROW, k, r0, r1, r2, r3, r4, r5, r6, r7, r8
+    xor rax, rax /* clear flags */
+    .if \k == 0
+    PROD [rsi +  0], \r0, \r1
+    .endif
+    .if \k == 1
+    PROD [rsi +  8], \r1, \r2
+    .elseif \k == 0
+    PROD [rsp + 72], \r1, \r2
+    .elseif \k < 0
+    PROD [rsp +  8], \r1, \r2
+    .endif
+    .if \k == 2
+    PROD [rsi + 16], \r2, \r3
+    .elseif \k == 1
+    PROD [rsp + 80], \r2, \r3
+    .elseif \k < 1
+    PROD [rsp + 16], \r2, \r3
+    .endif
+    .if \k == 3
+    PROD [rsi + 24], \r3, \r4
+    .elseif \k == 2
+    PROD [rsp + 88], \r3, \r4
+    .elseif \k < 2
+    PROD [rsp + 24], \r3, \r4
+    .endif
+    .if \k == 4
+    PROD [rsi + 32], \r4, \r5
+    .elseif \k == 3
+    PROD [rsp + 96], \r4, \r5
+    .elseif \k < 3
+    PROD [rsp + 32], \r4, \r5
+    .endif
+    .if \k == 5
+    PROD [rsi + 40], \r5, \r6
+    .elseif \k == 4
+    PROD [rsp + 104], \r5, \r6
+    .elseif \k < 4
+    PROD [rsp + 40], \r5, \r6
+    .endif
+    .if \k == 6
+    PROD [rsi + 48], \r6, \r7
+    .elseif \k == 5
+    PROD [rsp + 112], \r6, \r7
+    .elseif \k < 5
+    PROD [rsp + 48], \r6, \r7
+    .endif
+    .if \k == 7
+    PROD [rsi + 56], \r7, \r8
+    .elseif \k == 6
+    PROD [rsp + 120], \r7, \r8
+    .elseif \k < 6
+    PROD [rsp + 56], \r7, \r8
+    .endif
+    mov rax, 0
+    adox \r8, rax
+.endm
+
+/* r0..r8 += m p with m = r0 * -p^-1 mod 2^64, which clears r0 */
+/* r0 then takes the carries out of r8 and is the top word of the next step */
+.macro REDSTEP, r0, r1, r2, r3, r4, r5, r6, r7, r8
+    mov rdx, \r0
+    imul rdx, [rip + inv_min_p_mod_r]
+    xor rax, rax /* clear flags */
+    PROD [rip + p +  0], \r0, \r1
+    PROD [rip + p +  8], \r1, \r2
+    PROD [rip + p + 16], \r2, \r3
+    PROD [rip + p + 24], \r3, \r4
+    PROD [rip + p + 32], \r4, \r5
+    PROD [rip + p + 40], \r5, \r6
+    PROD [rip + p + 48], \r6, \r7
+    PROD [rip + p + 56], \r7, \r8
+    mov rax, 0
+    adox \r8, rax
+    adcx \r0, rax
+    adox \r0, rax
+.endm
+
+/* [rdi] := r0..r7 - p if that is not negative, else r0..r7 */
+.macro FINAL, r0, r1, r2, r3, r4, r5, r6, r7
+    mov [rdi +  0], \r0
+    mov [rdi +  8], \r1
+    mov [rdi + 16], \r2
+    mov [rdi + 24], \r3
+    mov [rdi + 32], \r4
+    mov [rdi + 40], \r5
+    mov [rdi + 48], \r6
+    mov [rdi + 56], \r7
+    sub \r0, [rip + p +  0]
+    sbb \r1, [rip + p +  8]
+    sbb \r2, [rip + p + 16]
+    sbb \r3, [rip + p + 24]
+    sbb \r4, [rip + p + 32]
+    sbb \r5, [rip + p + 40]
+    sbb \r6, [rip + p + 48]
+    sbb \r7, [rip + p + 56]
+    cmovc \r0, [rdi +  0]
+    cmovc \r1, [rdi +  8]
+    cmovc \r2, [rdi + 16]
+    cmovc \r3, [rdi + 24]
+    cmovc \r4, [rdi + 32]
+    cmovc \r5, [rdi + 40]
+    cmovc \r6, [rdi + 48]
+    cmovc \r7, [rdi + 56]
+    mov [rdi +  0], \r0
+    mov [rdi +  8], \r1
+    mov [rdi + 16], \r2
+    mov [rdi + 24], \r3
+    mov [rdi + 32], \r4
+    mov [rdi + 40], \r5
+    mov [rdi + 48], \r6
+    mov [rdi + 56], \r7
+.endm
+
+.global fp_mul3_mulx
+fp_mul3_mulx:
+    push rbp
+    push rbx
+    push r12
+    push r13
+    push r14
+    push r15
+
+    xor r8,  r8
+    xor r9,  r9
+    xor r10, r10
+    xor r11, r11
+    xor r12, r12
+    xor r13, r13
+    xor r14, r14
+    xor r15, r15
+    xor rbp, rbp
+
+    mov rbx, rdx
+
+    mov rdx, [rbx + 8*0]
+    MULROW  r8, r9, r10, r11, r12, r13, r14, r15, rbp
+    REDSTEP r8, r9, r10, r11, r12, r13, r14, r15, rbp
+
+    mov rdx, [rbx + 8*1]
+    MULROW  r9, r10, r11, r12, r13, r14, r15, rbp, r8
+    REDSTEP r9, r10, r11, r12, r13, r14, r15, rbp, r8
+
+    mov rdx, [rbx + 8*2]
+    MULROW  r10, r11, r12, r13, r14, r15, rbp, r8, r9
+    REDSTEP r10, r11, r12, r13, r14, r15, rbp, r8, r9
+
+    mov rdx, [rbx + 8*3]
+    MULROW  r11, r12, r13, r14, r15, rbp, r8, r9, r10
+    REDSTEP r11, r12, r13, r14, r15, rbp, r8, r9, r10
+
+    mov rdx, [rbx + 8*4]
+    MULROW  r12, r13, r14, r15, rbp, r8, r9, r10, r11
+    REDSTEP r12, r13, r14, r15, rbp, r8, r9, r10, r11
+
+    mov rdx, [rbx + 8*5]
+    MULROW  r13, r14, r15, rbp, r8, r9, r10, r11, r12
+    REDSTEP r13, r14, r15, rbp, r8, r9, r10, r11, r12
+
+    mov rdx, [rbx + 8*6]
+    MULROW  r14, r15, rbp, r8, r9, r10, r11, r12, r13
+    REDSTEP r14, r15, rbp, r8, r9, r10, r11, r12, r13
+
+    mov rdx, [rbx + 8*7]
+    MULROW  r15, rbp, r8, r9, r10, r11, r12, r13, r14
+    REDSTEP r15, rbp, r8, r9, r10, r11, r12, r13, r14
+
+    FINAL rbp, r8, r9, r10, r11, r12, r13, r14
+
+    pop r15
+    pop r14
+    pop r13
+    pop r12
+    pop rbx
+    pop rbp
+    ret
+
+
+/* the products of two different words once, as products with 2 a, which fits in 8 words since a < p < 2^511 */
+/* [rsp] holds the words of 2 a, [rsp + 64] the words of a shifted by one bit each */
+.global fp_sq2_mulx
+fp_sq2_mulx:
+    push rbp
+    push rbx
+    push r12
+    push r13
+    push r14
+    push r15
+
+    xor r8,  r8
+    xor r9,  r9
+    xor r10, r10
+    xor r11, r11
+    xor r12, r12
+    xor r13, r13
+    xor r14, r14
+    xor r15, r15
+    xor rbp, rbp
+
+    sub rsp, 128
+
+    mov rax, [rsi +  8]
+    mov rcx, [rsi +  0]
+    lea rbx, [rax + rax]
+    mov [rsp + 72], rbx
+    shld rax, rcx, 1
+    mov [rsp +  8], rax
+    mov rax, [rsi + 16]
+    mov rcx, [rsi +  8]
+    lea rbx, [rax + rax]
+    mov [rsp + 80], rbx
+    shld rax, rcx, 1
+    mov [rsp + 16], rax
+    mov rax, [rsi + 24]
+    mov rcx, [rsi + 16]
+    lea rbx, [rax + rax]
+    mov [rsp + 88], rbx
+    shld rax, rcx, 1
+    mov [rsp + 24], rax
+    mov rax, [rsi + 32]
+    mov rcx, [rsi + 24]
+    lea rbx, [rax + rax]
+    mov [rsp + 96], rbx
+    shld rax, rcx, 1
+    mov [rsp + 32], rax
+    mov rax, [rsi + 40]
+    mov rcx, [rsi + 32]
+    lea rbx, [rax + rax]
+    mov [rsp + 104], rbx
+    shld rax, rcx, 1
+    mov [rsp + 40], rax
+    mov rax, [rsi + 48]
+    mov rcx, [rsi + 40]
+    lea rbx, [rax + rax]
+    mov [rsp + 112], rbx
+    shld rax, rcx, 1
+    mov [rsp + 48], rax
+    mov rax, [rsi + 56]
+    mov rcx, [rsi + 48]
+    lea rbx, [rax + rax]
+    mov [rsp + 120], rbx
+    shld rax, rcx, 1
+    mov [rsp + 56], rax
+
+    mov rdx, [rsi + 8*0]
+    SQRROW  0, r8, r9, r10, r11, r12, r13, r14, r15, rbp
+    REDSTEP r8, r9, r10, r11, r12, r13, r14, r15, rbp
+
+    mov rdx, [rsi + 8*1]
+    SQRROW  1, r9, r10, r11, r12, r13, r14, r15, rbp, r8
+    REDSTEP r9, r10, r11, r12, r13, r14, r15, rbp, r8
+
+    mov rdx, [rsi + 8*2]
+    SQRROW  2, r10, r11, r12, r13, r14, r15, rbp, r8, r9
+    REDSTEP r10, r11, r12, r13, r14, r15, rbp, r8, r9
+
+    mov rdx, [rsi + 8*3]
+    SQRROW  3, r11, r12, r13, r14, r15, rbp, r8, r9, r10
+    REDSTEP r11, r12, r13, r14, r15, rbp, r8, r9, r10
+
+    mov rdx, [rsi + 8*4]
+    SQRROW  4, r12, r13, r14, r15, rbp, r8, r9, r10, r11
+    REDSTEP r12, r13, r14, r15, rbp, r8, r9, r10, r11
+
+    mov rdx, [rsi + 8*5]
+    SQRROW  5, r13, r14, r15, rbp, r8, r9, r10, r11, r12
+    REDSTEP r13, r14, r15, rbp, r8, r9, r10, r11, r12
+
+    mov rdx, [rsi + 8*6]
+    SQRROW  6, r14, r15, rbp, r8, r9, r10, r11, r12, r13
+    REDSTEP r14, r15, rbp, r8, r9, r10, r11, r12, r13
+
+    mov rdx, [rsi + 8*7]
+    SQRROW  7, r15, rbp, r8, r9, r10, r11, r12, r13, r14
+    REDSTEP r15, rbp, r8, r9, r10, r11, r12, r13, r14
+
+    add rsp, 128
+
+    FINAL rbp, r8, r9, r10, r11, r12, r13, r14
+
+    pop r15
+    pop r14
+    pop r13
+    pop r12
+    pop rbx
+    pop rbp
+    ret
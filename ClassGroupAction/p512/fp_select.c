@@ -0,0 +1,51 @@
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "params.h"
+#include "fp_backends.h"
+
+/* default: fp.s, the reduction of every step comes first and squaring is multiplication */
+void fp_mul3_default(fp *x, fp const *y, fp const *z);
+void fp_sq2_default(fp *x, fp const *y);
+
+/* mulx: fp_mulx.s, the final subtraction in registers and squaring with half the products */
+void fp_mul3_mulx(fp *x, fp const *y, fp const *z);
+void fp_sq2_mulx(fp *x, fp const *y);
+
+static int always(void)
+{
+    return 1;
+}
+
+static int bmi2_adx_supported(void)
+{
+    return __builtin_cpu_supports("bmi2") && __builtin_cpu_supports("adx");
+}
+
+const fp_backend fp_backends[] = {
+    {"mulx", bmi2_adx_supported, fp_mul3_mulx, fp_sq2_mulx},
+    {"default", always, fp_mul3_default, fp_sq2_default},
+};
+const size_t fp_backend_count = sizeof(fp_backends) / sizeof(fp_backends[0]);
+
+const fp_backend *fp_selected = &fp_backends[sizeof(fp_backends) / sizeof(fp_backends[0]) - 1];
+
+/* fp_mul3 and fp_sq2 in fp.s jump through these */
+void (*fp_mul3_impl)(fp *x, fp const *y, fp const *z) = fp_mul3_default;
+void (*fp_sq2_impl)(fp *x, fp const *y) = fp_sq2_default;
+
+__attribute__((constructor))
+static void fp_select(void)
+{
+    __builtin_cpu_init();
+    const char *forced = getenv("FP_BACKEND");
+    for (size_t b = 0; b < fp_backend_count; ++b) {
+        if (fp_backends[b].supported() && (forced == NULL || !strcmp(forced, fp_backends[b].name))) {
+            fp_selected = &fp_backends[b];
+            break;
+        }
+    }
+    fp_mul3_impl = fp_selected->mul3;
+    fp_sq2_impl = fp_selected->sq2;
+}
@@ -71,25 +71,25 @@ void subvec( int32_t *vec1, int32_t *vec2 ){
 	}
 }
 
-void reduce_32(int32_t *vec, int pool_vectors){
+void reduce_32(int32_t *vec, int pool_vectors, int32_t *vectors){
 	int32_t norm = l1norm(vec);
 	int i;
 	int counter = 0;
 	while (1){
 		int change = 0;
 		for(i=0; i<pool_vectors; i++){
-			int32_t plus_norm = l1normsum(vec,pool + i*K);
+			int32_t plus_norm = l1normsum(vec,vectors + i*K);
 			if(plus_norm < norm){
 				norm = plus_norm;
 				counter ++;
-				addvec(vec,pool +i*K);
+				addvec(vec,vectors +i*K);
 				change = 1;
 			} 
-			int32_t minus_norm = l1normdif(vec,pool + i*K);
+			int32_t minus_norm = l1normdif(vec,vectors + i*K);
 			if(minus_norm < norm){
 				norm = minus_norm;
 				counter ++;
-				subvec(vec,pool +i*K);
+				subvec(vec,vectors +i*K);
 				change = 1;
 			}
 		}
@@ -99,7 +99,7 @@ void reduce_32(int32_t *vec, int pool_vectors){
 	}
 }
 
-void reduce(int8_t *vec, int trials, int pool_vectors){
+void reduce(int8_t *vec, int trials, int pool_vectors, int32_t *vectors){
 	int32_t VEC[K];
 	for(int i=0; i<K; i++){
 		VEC[i] = (int32_t) vec[i];
@@ -108,7 +108,7 @@ void reduce(int8_t *vec, int trials, int pool_vectors){
 	int32_t best[K];
 	int32_t best_len;
 
-	reduce_32(VEC,pool_vectors);
+	reduce_32(VEC,pool_vectors,vectors);
 
 	memcpy(best,VEC,sizeof(int32_t)*K);
 	best_len = l1norm(VEC);
@@ -118,10 +118,10 @@ void reduce(int8_t *vec, int trials, int pool_vectors){
 
 		for(int j=0; j<2 ; j++){
 			int index = rand()%POOL_SIZE;
-			addvec(VEC,pool+K*index);
+			addvec(VEC,vectors+K*index);
 		}
 
-		reduce_32(VEC,pool_vectors);
+		reduce_32(VEC,pool_vectors,vectors);
 		int norm = l1norm(VEC);
 
 		if(norm < best_len){
@@ -7,6 +7,11 @@
 #include <math.h>
 #include "stdlib.h"
 
-void reduce(int8_t *vec, int trials, int pool_vectors);
+// the pool of short vectors of the relation lattice, NUM_PRIMES entries per vector
+#define POOL_SIZE 10000
+extern int32_t pool[];
+
+// reduces vec with the first pool_vectors vectors of a copy of the pool
+void reduce(int8_t *vec, int trials, int pool_vectors, int32_t *vectors);
 
 #endif
\ No newline at end of file
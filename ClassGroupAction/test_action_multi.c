@@ -0,0 +1,53 @@
+
+#include <stdio.h>
+#include <string.h>
+
+#include "csidh.h"
+#include "classgroup.h"
+
+/* action_multi against action on every curve, for groups of 1 to 9 curves. */
+/* the groups of at least ACTION_MULTI_MIN curves go through the lanes, 9 curves are a full group and a single one. */
+/* the lanes of a round whose kernel point is at infinity have to skip the prime and take the step in a later round, */
+/* so the test runs until that has happened at least once. */
+
+#define MAX_CURVES 9
+#define MAX_RUNS 8
+
+int main(void)
+{
+    init_classgroup();
+
+    int failures = 0;
+    for (int run = 0; run < MAX_RUNS && (run == 0 || action_multi_infinity == 0); ++run) {
+        for (size_t n = 1; n <= MAX_CURVES; ++n) {
+            public_key in[MAX_CURVES], out[MAX_CURVES], expected[MAX_CURVES];
+            private_key priv;
+
+            for (size_t j = 0; j < n; ++j) {
+                csidh_private(&priv);
+                action(&in[j], &base, &priv);
+            }
+            csidh_private(&priv);
+
+            for (size_t j = 0; j < n; ++j)
+                action(&expected[j], &in[j], &priv);
+            action_multi(out, in, n, &priv);
+
+            for (size_t j = 0; j < n; ++j) {
+                if (memcmp(&out[j], &expected[j], sizeof(public_key))) {
+                    printf("action_multi: curve %zu of %zu differs from action\n", j, n);
+                    ++failures;
+                }
+            }
+        }
+    }
+
+    printf("action_multi: %lu lanes with the kernel point at infinity\n", (unsigned long) action_multi_infinity);
+    if (action_multi_infinity == 0) {
+        printf("action_multi: no lane had its kernel point at infinity\n");
+        ++failures;
+    }
+
+    printf("%s\n", failures ? "FAILED" : "OK");
+    return failures != 0;
+}
@@ -0,0 +1,312 @@
+#include "async.h"
+#include <pthread.h>
+#include <stdlib.h>
+
+// messages are hashed in chunks, so that a cancellation does not wait for a large message to be hashed
+#define ASYNC_HASH_CHUNK (1 << 20)
+
+#define ASYNC_RSIGN 0
+#define ASYNC_RVERIFY 1
+#define ASYNC_LRSIGN 2
+#define ASYNC_LRVERIFY 3
+
+struct async_job {
+	int type;
+	const unsigned char *sk;
+	int64_t I;
+	const unsigned char *pks;
+	int64_t rings;
+	const unsigned char *m;
+	uint64_t mlen;
+	unsigned char *sig;
+	const unsigned char *signature;
+	uint64_t *sig_len;
+	async_callback callback;
+	void *user;
+	int threads;
+	parallel_control control;
+
+	// state and result are set before the callback, finished after it
+	pthread_mutex_t lock;
+	pthread_cond_t finished_cond;
+	int state;
+	int result;
+	int finished;
+
+	async_job *next;
+};
+
+struct async_executor {
+	pthread_mutex_t lock;
+	pthread_cond_t wake;
+	async_job *head;
+	async_job *tail;
+	async_job **running;
+	int stopping;
+	int workers;
+	int threads;
+	pthread_t *ids;
+};
+
+typedef struct {
+	async_executor *executor;
+	int worker;
+} async_worker;
+
+static int async_hash_message(async_job *job, unsigned char *message_hash){
+	message_hash_ctx ctx;
+	message_hash_init(&ctx);
+	for (uint64_t offset = 0; offset < job->mlen; offset += ASYNC_HASH_CHUNK)
+	{
+		if (parallel_cancelled(&job->control))
+			return -1;
+
+		uint64_t len = job->mlen - offset;
+		if (len > ASYNC_HASH_CHUNK)
+			len = ASYNC_HASH_CHUNK;
+		message_hash_update(&ctx, job->m + offset, len);
+	}
+	message_hash_final(&ctx, message_hash);
+	return 0;
+}
+
+static void async_run(async_job *job){
+	pthread_mutex_lock(&job->lock);
+	int cancelled = parallel_cancelled(&job->control);
+	if (!cancelled)
+		job->state = ASYNC_RUNNING;
+	pthread_mutex_unlock(&job->lock);
+
+	int result = -1;
+	unsigned char message_hash[HASH_BYTES];
+	if (!cancelled && async_hash_message(job, message_hash) == 0){
+		switch (job->type){
+			case ASYNC_RSIGN:
+				result = rsign_controlled(job->sk, job->I, job->pks, job->rings, message_hash, job->sig, job->sig_len, job->threads, &job->control);
+				break;
+			case ASYNC_RVERIFY:
+				result = rverify_controlled(job->pks, job->rings, message_hash, job->signature, job->threads, &job->control);
+				break;
+			case ASYNC_LRSIGN:
+				result = lrsign_controlled(job->sk, job->I, job->pks, job->rings, message_hash, job->sig, job->sig_len, job->threads, &job->control);
+				break;
+			case ASYNC_LRVERIFY:
+				result = lrverify_controlled(job->pks, job->rings, message_hash, job->signature, job->threads, &job->control);
+				break;
+		}
+	}
+
+	pthread_mutex_lock(&job->lock);
+	job->result = result;
+	job->state = parallel_cancelled(&job->control) ? ASYNC_CANCELLED : ASYNC_DONE;
+	pthread_mutex_unlock(&job->lock);
+
+	if (job->callback != NULL)
+		job->callback(job, job->user);
+
+	// only now the job can be freed
+	pthread_mutex_lock(&job->lock);
+	job->finished = 1;
+	pthread_cond_broadcast(&job->finished_cond);
+	pthread_mutex_unlock(&job->lock);
+}
+
+static void *async_work(void *in){
+	async_worker *worker = (async_worker *) in;
+	async_executor *executor = worker->executor;
+
+	pthread_mutex_lock(&executor->lock);
+	while (1){
+		while (executor->head == NULL && !executor->stopping)
+			pthread_cond_wait(&executor->wake, &executor->lock);
+
+		// the queue is drained before stopping, the remaining jobs are cancelled by then
+		if (executor->head == NULL)
+			break;
+
+		async_job *job = executor->head;
+		executor->head = job->next;
+		if (executor->head == NULL)
+			executor->tail = NULL;
+		executor->running[worker->worker] = job;
+		pthread_mutex_unlock(&executor->lock);
+
+		async_run(job);
+
+		pthread_mutex_lock(&executor->lock);
+		executor->running[worker->worker] = NULL;
+	}
+	pthread_mutex_unlock(&executor->lock);
+
+	free(worker);
+	return NULL;
+}
+
+async_executor *async_executor_new(int workers, int threads){
+	if (workers < 1)
+		workers = 1;
+	if (threads < 1)
+		threads = 1;
+
+	async_executor *executor = calloc(1, sizeof(async_executor));
+	if (executor == NULL)
+		return NULL;
+
+	pthread_mutex_init(&executor->lock, NULL);
+	pthread_cond_init(&executor->wake, NULL);
+	executor->threads = threads;
+	executor->running = calloc(workers, sizeof(async_job *));
+	executor->ids = calloc(workers, sizeof(pthread_t));
+	if (executor->running == NULL || executor->ids == NULL){
+		async_executor_free(executor);
+		return NULL;
+	}
+
+	// the workers that did start are stopped again if one of them can not be started
+	for (int w = 0; w < workers; ++w)
+	{
+		async_worker *worker = malloc(sizeof(async_worker));
+		if (worker == NULL){
+			async_executor_free(executor);
+			return NULL;
+		}
+		worker->executor = executor;
+		worker->worker = w;
+		if (pthread_create(&executor->ids[w], NULL, async_work, worker) != 0){
+			free(worker);
+			async_executor_free(executor);
+			return NULL;
+		}
+		executor->workers++;
+	}
+	return executor;
+}
+
+void async_executor_free(async_executor *executor){
+	pthread_mutex_lock(&executor->lock);
+	executor->stopping = 1;
+	for (async_job *job = executor->head; job != NULL; job = job->next)
+	{
+		parallel_cancel(&job->control);
+	}
+	for (int w = 0; w < executor->workers; ++w)
+	{
+		if (executor->running[w] != NULL)
+			parallel_cancel(&executor->running[w]->control);
+	}
+	pthread_cond_broadcast(&executor->wake);
+	pthread_mutex_unlock(&executor->lock);
+
+	for (int w = 0; w < executor->workers; ++w)
+	{
+		pthread_join(executor->ids[w], NULL);
+	}
+
+	pthread_mutex_destroy(&executor->lock);
+	pthread_cond_destroy(&executor->wake);
+	free(executor->running);
+	free(executor->ids);
+	free(executor);
+}
+
+static async_job *async_submit(async_executor *executor, async_job *job){
+	job->threads = executor->threads;
+	parallel_control_init(&job->control);
+	pthread_mutex_init(&job->lock, NULL);
+	pthread_cond_init(&job->finished_cond, NULL);
+	job->state = ASYNC_PENDING;
+	job->result = -1;
+
+	pthread_mutex_lock(&executor->lock);
+	if (executor->stopping){
+		pthread_mutex_unlock(&executor->lock);
+		pthread_mutex_destroy(&job->lock);
+		pthread_cond_destroy(&job->finished_cond);
+		free(job);
+		return NULL;
+	}
+
+	if (executor->tail != NULL)
+		executor->tail->next = job;
+	else
+		executor->head = job;
+	executor->tail = job;
+	pthread_cond_signal(&executor->wake);
+	pthread_mutex_unlock(&executor->lock);
+	return job;
+}
+
+// the type and all the inputs are set before the job is queued, a worker may pick it up at once
+static async_job *async_new(async_executor *executor, int type, const unsigned char *sk, const int64_t I, const unsigned char *pks, const int64_t rings, const unsigned char *m, uint64_t mlen, unsigned char *sig, const unsigned char *signature, uint64_t *sig_len, async_callback callback, void *user){
+	async_job *job = calloc(1, sizeof(async_job));
+	if (job == NULL)
+		return NULL;
+
+	job->type = type;
+	job->sk = sk;
+	job->I = I;
+	job->pks = pks;
+	job->rings = rings;
+	job->m = m;
+	job->mlen = mlen;
+	job->sig = sig;
+	job->signature = signature;
+	job->sig_len = sig_len;
+	job->callback = callback;
+	job->user = user;
+	return async_submit(executor, job);
+}
+
+async_job *async_rsign(async_executor *executor, const unsigned char *sk, const int64_t I, const unsigned char *pks, const int64_t rings, const unsigned char *m, uint64_t mlen, unsigned char *sig, uint64_t *sig_len, async_callback callback, void *user){
+	return async_new(executor, ASYNC_RSIGN, sk, I, pks, rings, m, mlen, sig, NULL, sig_len, callback, user);
+}
+
+async_job *async_rverify(async_executor *executor, const unsigned char *pks, const int64_t rings, const unsigned char *m, uint64_t mlen, const unsigned char *sig, async_callback callback, void *user){
+	return async_new(executor, ASYNC_RVERIFY, NULL, 0, pks, rings, m, mlen, NULL, sig, NULL, callback, user);
+}
+
+async_job *async_lrsign(async_executor *executor, const unsigned char *sk, const int64_t I, const unsigned char *pks, const int64_t rings, const unsigned char *m, uint64_t mlen, unsigned char *sig, uint64_t *sig_len, async_callback callback, void *user){
+	return async_new(executor, ASYNC_LRSIGN, sk, I, pks, rings, m, mlen, sig, NULL, sig_len, callback, user);
+}
+
+async_job *async_lrverify(async_executor *executor, const unsigned char *pks, const int64_t rings, const unsigned char *m, uint64_t mlen, const unsigned char *sig, async_callback callback, void *user){
+	return async_new(executor, ASYNC_LRVERIFY, NULL, 0, pks, rings, m, mlen, NULL, sig, NULL, callback, user);
+}
+
+int async_poll(async_job *job){
+	pthread_mutex_lock(&job->lock);
+	int state = job->state;
+	pthread_mutex_unlock(&job->lock);
+	return state;
+}
+
+int async_result(async_job *job){
+	pthread_mutex_lock(&job->lock);
+	int result = job->result;
+	pthread_mutex_unlock(&job->lock);
+	return result;
+}
+
+int64_t async_progress(async_job *job){
+	return atomic_load(&job->control.completed);
+}
+
+void async_cancel(async_job *job){
+	parallel_cancel(&job->control);
+}
+
+void async_wait(async_job *job){
+	pthread_mutex_lock(&job->lock);
+	while (!job->finished)
+		pthread_cond_wait(&job->finished_cond, &job->lock);
+	pthread_mutex_unlock(&job->lock);
+}
+
+void async_job_free(async_job *job){
+	async_cancel(job);
+	async_wait(job);
+
+	pthread_mutex_destroy(&job->lock);
+	pthread_cond_destroy(&job->finished_cond);
+	free(job);
+}
@@ -0,0 +1,42 @@
+#ifndef ASYNC_H
+#define ASYNC_H
+
+#include "rsign.h"
+#include "lrsign.h"
+#include "parallel.h"
+#include "stdint.h"
+
+#define ASYNC_PENDING 0
+#define ASYNC_RUNNING 1
+#define ASYNC_DONE 2
+#define ASYNC_CANCELLED 3
+
+typedef struct async_executor async_executor;
+typedef struct async_job async_job;
+
+// called on a worker thread once a job is done or cancelled, the job must not be freed from the callback
+typedef void (*async_callback)(async_job *job, void *user);
+
+// workers jobs run at the same time, each of them with threads threads. returns NULL if memory runs out or a worker can not be started
+async_executor *async_executor_new(int workers, int threads);
+// cancels the jobs that did not finish yet and stops the workers, the jobs themselves still have to be freed
+void async_executor_free(async_executor *executor);
+
+// the message, keys and signature buffers must stay valid until the job is done or cancelled
+async_job *async_rsign(async_executor *executor, const unsigned char *sk_I, const int64_t I, const unsigned char *pks, const int64_t ring_size, const unsigned char *m, uint64_t mlen, unsigned char *sig, uint64_t *sig_len, async_callback callback, void *user);
+async_job *async_rverify(async_executor *executor, const unsigned char *pks, const int64_t ring_size, const unsigned char *m, uint64_t mlen, const unsigned char *sig, async_callback callback, void *user);
+async_job *async_lrsign(async_executor *executor, const unsigned char *sk_I, const int64_t I, const unsigned char *pks, const int64_t ring_size, const unsigned char *m, uint64_t mlen, unsigned char *sig, uint64_t *sig_len, async_callback callback, void *user);
+async_job *async_lrverify(async_executor *executor, const unsigned char *pks, const int64_t ring_size, const unsigned char *m, uint64_t mlen, const unsigned char *sig, async_callback callback, void *user);
+
+// one of ASYNC_PENDING, ASYNC_RUNNING, ASYNC_DONE or ASYNC_CANCELLED
+int async_poll(async_job *job);
+// the return value of the sign or verify call, -1 if the job was cancelled
+int async_result(async_job *job);
+// number of executions completed so far, this includes the executions of restarts
+int64_t async_progress(async_job *job);
+void async_cancel(async_job *job);
+void async_wait(async_job *job);
+// cancels the job if it is not done yet and waits for it
+void async_job_free(async_job *job);
+
+#endif
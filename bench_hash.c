@@ -0,0 +1,163 @@
+#include "rsign.h"
+#include "parameters.h"
+#include "keccak_dispatch.h"
+#include <stdio.h>
+#include "stdlib.h"
+
+// known answers for both hash suites, then the cost of both suites on the input lengths the scheme hashes
+#define REPETITIONS 1000
+#define KAT_BYTES 32
+
+static inline
+uint64_t rdtsc(){
+    unsigned int lo,hi;
+    __asm__ __volatile__ ("rdtsc" : "=a" (lo), "=d" (hi));
+    return ((uint64_t)hi << 32) | lo;
+}
+
+typedef struct {
+	const char *name;
+	int suite;
+	unsigned char domain;
+	int pattern_bytes; // message of the bytes 0x00 to 0xFA repeated, -1 for the empty message
+	const char *expected;
+} hash_kat;
+
+// SHAKE128 from FIPS 202, TurboSHAKE128 with domain 0x1F from RFC 9861
+// the domain 0x07 vectors are KangarooTwelve with an empty customization string (XKCP/tests/TestVectors/KangarooTwelve.txt),
+// which is TurboSHAKE128 of the message followed by the byte 0x00
+static const hash_kat kats[] = {
+	{"SHAKE128(empty)", HASH_SUITE_SHAKE128, 0x1F, -1, "7f9c2ba4e88f827d616045507605853ed73b8093f6efbc88eb1a6eacfa66ef26"},
+	{"TurboSHAKE128(empty, 0x1F)", HASH_SUITE_TURBOSHAKE128, 0x1F, -1, "1e415f1c5983aff2169217277d17bb538cd945a397ddec541f1ce41af2c1b74c"},
+	{"K12(empty)", HASH_SUITE_TURBOSHAKE128, 0x07, 0, "1ac2d450fc3b4205d19da7bfca1b37513c0803577ac7167f06fe2ce1f0ef39e5"},
+	{"K12(pattern 17 bytes)", HASH_SUITE_TURBOSHAKE128, 0x07, 17, "6bf75fa2239198db4772e36478f8e19b0f371205f6a9a93a273f51df37122888"},
+	{"K12(pattern 289 bytes)", HASH_SUITE_TURBOSHAKE128, 0x07, 289, "0c315ebcdedbf61426de7dcf8fb725d1e74675d7f5327a5067f367b108ecb67c"},
+};
+
+static void from_hex(const char *hex, unsigned char *out, int len){
+	for (int i = 0; i < len; ++i)
+	{
+		sscanf(hex + 2*i, "%2hhx", out + i);
+	}
+}
+
+static void suite_hash(int suite, const unsigned char *in, size_t len, unsigned char domain, unsigned char *out, size_t outlen){
+	if (suite == HASH_SUITE_TURBOSHAKE128){
+		TURBOSHAKE128(out, outlen, in, len, domain);
+	}
+	else{
+		SHAKE128(out, outlen, in, len);
+	}
+}
+
+static int check_kats(){
+	int failures = 0;
+	unsigned char in[512], out[KAT_BYTES], expected[KAT_BYTES];
+	for (size_t k = 0; k < sizeof(kats)/sizeof(kats[0]); ++k)
+	{
+		// the K12 vectors end with the encoding of the empty customization string
+		size_t len = 0;
+		if (kats[k].pattern_bytes >= 0){
+			for (int i = 0; i < kats[k].pattern_bytes; ++i)
+			{
+				in[len++] = i % 251;
+			}
+			in[len++] = 0;
+		}
+
+		suite_hash(kats[k].suite, in, len, kats[k].domain, out, KAT_BYTES);
+		from_hex(kats[k].expected, expected, KAT_BYTES);
+		int ok = memcmp(out, expected, KAT_BYTES) == 0;
+		failures += !ok;
+		printf("%-28s %s \n", kats[k].name, ok ? "OK" : "FAIL");
+	}
+	return failures;
+}
+
+// the macros and the parallel hash of the suite this is compiled with have to agree with the reference
+static int check_suite(){
+	int failures = 0;
+	unsigned char in[HASH_LANES][400];
+	for (int lane = 0; lane < HASH_LANES; ++lane)
+	{
+		for (int i = 0; i < 400; ++i)
+		{
+			in[lane][i] = i + 7*lane;
+		}
+	}
+
+	for (unsigned int len = 0; len <= 400; len += 50)
+	{
+		unsigned char reference[HASH_LANES][HASH_BYTES], out[HASH_BYTES], expanded[2*SHAKE128_RATE];
+		for (int lane = 0; lane < HASH_LANES; ++lane)
+		{
+			suite_hash(HASH_SUITE, in[lane], len, HASH_DOMAIN, reference[lane], HASH_BYTES);
+		}
+
+		HASH(in[0], len, out);
+		failures += memcmp(out, reference[0], HASH_BYTES) != 0;
+
+		HASH_CTX ctx;
+		HASH_INIT(&ctx);
+		HASH_UPDATE(&ctx, in[0], len/3);
+		HASH_UPDATE(&ctx, in[0] + len/3, len - len/3);
+		HASH_FINAL(&ctx, out);
+		failures += memcmp(out, reference[0], HASH_BYTES) != 0;
+
+		EXPAND(in[0], len, expanded, sizeof(expanded));
+		unsigned char squeezed[sizeof(expanded)];
+		EXPAND_INIT(&ctx, in[0], len);
+		EXPAND_SQUEEZE(&ctx, squeezed, 5);
+		EXPAND_SQUEEZE(&ctx, squeezed + 5, sizeof(squeezed) - 5);
+		failures += memcmp(expanded, reference[0], HASH_BYTES) != 0;
+		failures += memcmp(expanded, squeezed, sizeof(expanded)) != 0;
+
+		unsigned char lanes_out[HASH_LANES][HASH_BYTES];
+		const unsigned char *lanes_in[HASH_LANES];
+		unsigned char *lanes_outp[HASH_LANES];
+		for (int lane = 0; lane < HASH_LANES; ++lane)
+		{
+			lanes_in[lane] = in[lane];
+			lanes_outp[lane] = lanes_out[lane];
+		}
+		hash_lanes(lanes_in, len, lanes_outp, HASH_LANES);
+		failures += memcmp(lanes_out, reference, sizeof(lanes_out)) != 0;
+		memset(lanes_out, 0, sizeof(lanes_out));
+		hash_lanes(lanes_in, len, lanes_outp, HASH_LANES_NARROW);
+		failures += memcmp(lanes_out, reference, HASH_LANES_NARROW*HASH_BYTES) != 0;
+	}
+
+	printf("%-28s %s \n", HASH_SUITE == HASH_SUITE_TURBOSHAKE128 ? "TurboSHAKE128 suite" : "SHAKE128 suite", failures ? "FAIL" : "OK");
+	return failures;
+}
+
+int main(int argc, char const *argv[])
+{
+	printf("Keccak backend %s \n\n", keccak_selected->name);
+	int failures = check_kats() + check_suite();
+
+	// a seed tree node, a Merkle node, a commitment and the expansion of the randomness of a ring of 64 members
+	const unsigned int lengths[] = {SEED_BYTES + HASH_BYTES + 4, 2*HASH_BYTES, COMMIT_INPUT_BYTES, SEED_BYTES};
+	const unsigned int outlens[] = {2*SEED_BYTES, HASH_BYTES, HASH_BYTES, 64*SEED_BYTES};
+	unsigned char in[COMMIT_INPUT_BYTES] = {0};
+	unsigned char out[64*SEED_BYTES];
+
+	printf("\ninput bytes   output bytes   SHAKE128 cycles   TurboSHAKE128 cycles \n");
+	for (size_t l = 0; l < sizeof(lengths)/sizeof(lengths[0]); ++l)
+	{
+		uint64_t cycles[2];
+		for (int suite = HASH_SUITE_SHAKE128; suite <= HASH_SUITE_TURBOSHAKE128; ++suite)
+		{
+			uint64_t t = rdtsc();
+			for (int i = 0; i < REPETITIONS; ++i)
+			{
+				in[0] = out[0];
+				suite_hash(suite, in, lengths[l], HASH_DOMAIN, out, outlens[l]);
+			}
+			cycles[suite] = (rdtsc() - t)/REPETITIONS;
+		}
+		printf("%11u   %12u   %15lu   %20lu \n", lengths[l], outlens[l], cycles[HASH_SUITE_SHAKE128], cycles[HASH_SUITE_TURBOSHAKE128]);
+	}
+
+	return failures != 0;
+}
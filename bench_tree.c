@@ -0,0 +1,73 @@
+#include "rsign.h"
+#include "parameters.h"
+#include <stdio.h>
+#include "stdlib.h"
+
+// commits to rings of 2^k and 2^k+1 members, the sizes just above a power of two are where padding costs the most
+#define MIN_LOG_RING 4
+#define MAX_LOG_RING 10
+#define REPETITIONS 8
+
+static inline
+uint64_t rdtsc(){
+    unsigned int lo,hi;
+    __asm__ __volatile__ ("rdtsc" : "=a" (lo), "=d" (hi));
+    return ((uint64_t)hi << 32) | lo;
+}
+
+int main(int argc, char const *argv[])
+{
+	init_action();
+
+	int64_t max_rings = (((int64_t) 1) << MAX_LOG_RING) + 1;
+	unsigned char *pks = aligned_alloc(32, max_rings*PK_BYTES);
+	unsigned char sk[SK_BYTES];
+	for (int64_t j = 0; j < max_rings; ++j)
+	{
+		keygen(pks + j*PK_BYTES, sk);
+	}
+
+	unsigned char seed[SEED_BYTES] = {0};
+	unsigned char salt[HASH_BYTES] = {0};
+	unsigned char root[HASH_BYTES];
+	unsigned char path[HASH_BYTES*(MAX_LOG_RING+1)];
+	unsigned char commitment_randomness[SEED_BYTES];
+	GRPELTS2 r;
+	init_grpelt(r);
+
+	printf("%s tree \n", UNPADDED_TREE ? "unpadded" : "padded");
+	printf("ring size   tree nodes   tree cycles   commit_to_ring cycles \n");
+	for (int k = MIN_LOG_RING; k <= MAX_LOG_RING; ++k)
+	{
+		for (int64_t rings = ((int64_t) 1) << k; rings <= (((int64_t) 1) << k) + 1; ++rings)
+		{
+			ring_ctx ring;
+			ring_ctx_view(&ring, pks, rings);
+			unsigned char *buf = malloc(SEED_BYTES*(rings+2));
+			unsigned char *commitments = calloc(ring.nodes, HASH_BYTES);
+			uint64_t tree_cycles = 0;
+			uint64_t commit_cycles = 0;
+
+			for (int i = 0; i < REPETITIONS; ++i)
+			{
+				// only the dummy commitments and the tree, on top of whatever the commitments are
+				uint64_t t = rdtsc();
+				EXPAND(seed, SEED_BYTES, commitments + rings*HASH_BYTES, (ring.nodes-rings)*HASH_BYTES);
+				build_unbalanced_tree_and_path(commitments, ring.leaves, i % rings, root, path);
+				tree_cycles += rdtsc() - t;
+
+				t = rdtsc();
+				commit_to_ring(seed, i, &ring, i % rings, salt, &r, buf, commitments, commitment_randomness, root, path, 1, NULL);
+				commit_cycles += rdtsc() - t;
+			}
+
+			printf("%9ld   %10ld   %11lu   %21lu \n", rings, ring.nodes, tree_cycles/REPETITIONS, commit_cycles/REPETITIONS);
+			free(buf);
+			free(commitments);
+		}
+	}
+
+	clear_grpelt(r);
+	free(pks);
+	return 0;
+}
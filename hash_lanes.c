@@ -0,0 +1,46 @@
+#include "hash_lanes.h"
+#include "keccak_dispatch.h"
+
+void hash_lanes(const unsigned char *const *in, unsigned int len, unsigned char *const *out, int count){
+	_Alignas(KeccakP1600times8_statesAlignment) unsigned char states[KeccakP1600times8_statesSizeInBytes];
+	const unsigned char domain = HASH_DOMAIN, last = 0x80;
+
+	int width = (count <= HASH_LANES_NARROW) ? HASH_LANES_NARROW : HASH_LANES;
+	const keccak_parallel *parallel = (width == HASH_LANES_NARROW) ? &keccak_selected->times4 : &keccak_selected->times8;
+#if HASH_SUITE == HASH_SUITE_TURBOSHAKE128
+	void (*permute)(void *states) = parallel->permute_all_12rounds;
+#else
+	void (*permute)(void *states) = parallel->permute_all_24rounds;
+#endif
+	parallel->initialize_all(states);
+
+	const unsigned char *lanes[HASH_LANES];
+	for (int lane = 0; lane < width; ++lane)
+	{
+		lanes[lane] = (lane < count) ? in[lane] : in[0];
+	}
+
+	unsigned int offset = 0;
+	while (len - offset >= SHAKE128_RATE){
+		for (int lane = 0; lane < width; ++lane)
+		{
+			parallel->add_bytes(states, lane, lanes[lane] + offset, 0, SHAKE128_RATE);
+		}
+		permute(states);
+		offset += SHAKE128_RATE;
+	}
+
+	// pad and squeeze one block, HASH_BYTES fits in it
+	for (int lane = 0; lane < width; ++lane)
+	{
+		parallel->add_bytes(states, lane, lanes[lane] + offset, 0, len - offset);
+		parallel->add_bytes(states, lane, &domain, len - offset, 1);
+		parallel->add_bytes(states, lane, &last, SHAKE128_RATE - 1, 1);
+	}
+	permute(states);
+
+	for (int lane = 0; lane < count; ++lane)
+	{
+		parallel->extract_bytes(states, lane, out[lane], 0, HASH_BYTES);
+	}
+}
@@ -0,0 +1,15 @@
+#ifndef HASH_LANES_H
+#define HASH_LANES_H
+
+#include "parameters.h"
+
+// number of inputs hashed at once, with the 8-way Keccak permutation, or two calls of the 4-way one if the backend has no 8-way one
+#define HASH_LANES 8
+// up to this many inputs take a single call of the 4-way permutation
+#define HASH_LANES_NARROW 4
+
+// HASH of up to HASH_LANES inputs of the same length, one permutation call for all of them
+// only the first count inputs are read and the first count outputs are written, the unused lanes hash the first input again
+void hash_lanes(const unsigned char *const *in, unsigned int len, unsigned char *const *out, int count);
+
+#endif
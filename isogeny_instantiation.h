@@ -5,12 +5,24 @@
 #include "gmp.h"
 #include "ClassGroupAction/classgroup.h"
 #include "ClassGroupAction/csidh.h"
+#include "parallel.h"
 
 #define S1_BYTES 33
 #define S3_BYTES 33
 #define XELT_BYTES 64
 #define PK_BYTES XELT_BYTES
-#define init_action init_classgroup
+
+// per NUMA node copies of the Babai basis and the pool of short vectors that sampling the group elements uses
+static inline int replicate_classgroup(void *arg, int node){
+	return classgroup_replicate(node);
+}
+
+#define init_action() { \
+	init_classgroup(); \
+	if (parallel_nodes() > 1 && parallel_on_nodes(replicate_classgroup, NULL) == 0) \
+		classgroup_node = parallel_current_node; \
+}
+
 #define GRPELTS1 mpz_t
 #define GRPELTS1L GRPELTS1
 #define GRPELTS2 GRPELTS1
@@ -60,6 +72,11 @@ mpz_fdiv_r(out, out,cn)
 	action(out, in, pg); \
 }
 
+// n curves with the same group element, in lockstep
+#define finish_action_multi(out,in,n,pg){ \
+	action_multi(out, in, n, pg); \
+}
+
 /*#define do_half_action(pg,g) 
 #define do_half_tag_action(pg,g)
 #define finish_action(out,in,pg) memcpy(out,in,PK_BYTES) */
@@ -75,5 +92,7 @@ mpz_fdiv_r(out, out,cn)
 
 #define is_equal_X(A,B) (memcmp(&A,&B,sizeof(XELT)) == 0)
 
+#define is_valid_pk(X) validate(X)
+
 #define init_grpelt(g) mpz_init(g)
 #define clear_grpelt(g) mpz_clear(g) 
\ No newline at end of file
@@ -0,0 +1,115 @@
+#include "keccak_dispatch.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define PARALLEL_FUNCTIONS(prefix) \
+	void prefix##_InitializeAll(void *states); \
+	void prefix##_AddBytes(void *states, unsigned int instanceIndex, const unsigned char *data, unsigned int offset, unsigned int length); \
+	void prefix##_PermuteAll_12rounds(void *states); \
+	void prefix##_PermuteAll_24rounds(void *states); \
+	void prefix##_ExtractBytes(const void *states, unsigned int instanceIndex, unsigned char *data, unsigned int offset, unsigned int length);
+
+#define PARALLEL(prefix) {prefix##_InitializeAll, prefix##_AddBytes, prefix##_PermuteAll_12rounds, prefix##_PermuteAll_24rounds, prefix##_ExtractBytes}
+
+// the functions of the XKCP target that keccak_dispatch forwards to, under the prefix the Makefile gave them
+#define BACKEND(target, supported) \
+	int target##_SHAKE128(unsigned char *output, size_t outputByteLen, const unsigned char *input, size_t inputByteLen); \
+	HashReturn target##_Keccak_HashInitialize(Keccak_HashInstance *hashInstance, unsigned int rate, unsigned int capacity, unsigned int hashbitlen, unsigned char delimitedSuffix); \
+	HashReturn target##_Keccak_HashUpdate(Keccak_HashInstance *hashInstance, const BitSequence *data, BitLength databitlen); \
+	HashReturn target##_Keccak_HashFinal(Keccak_HashInstance *hashInstance, BitSequence *hashval); \
+	HashReturn target##_Keccak_HashSqueeze(Keccak_HashInstance *hashInstance, BitSequence *data, BitLength databitlen); \
+	int target##_KeccakWidth1600_12rounds_Sponge(unsigned int rate, unsigned int capacity, const unsigned char *input, size_t inputByteLen, unsigned char suffix, unsigned char *output, size_t outputByteLen); \
+	int target##_KeccakWidth1600_12rounds_SpongeInitialize(KeccakWidth1600_12rounds_SpongeInstance *spongeInstance, unsigned int rate, unsigned int capacity); \
+	int target##_KeccakWidth1600_12rounds_SpongeAbsorb(KeccakWidth1600_12rounds_SpongeInstance *spongeInstance, const unsigned char *data, size_t dataByteLen); \
+	int target##_KeccakWidth1600_12rounds_SpongeAbsorbLastFewBits(KeccakWidth1600_12rounds_SpongeInstance *spongeInstance, unsigned char delimitedData); \
+	int target##_KeccakWidth1600_12rounds_SpongeSqueeze(KeccakWidth1600_12rounds_SpongeInstance *spongeInstance, unsigned char *data, size_t dataByteLen); \
+	PARALLEL_FUNCTIONS(target##_KeccakP1600times4) \
+	PARALLEL_FUNCTIONS(target##_KeccakP1600times8) \
+	static const keccak_backend target##_backend = { \
+		#target, supported, \
+		target##_SHAKE128, \
+		target##_Keccak_HashInitialize, target##_Keccak_HashUpdate, target##_Keccak_HashFinal, target##_Keccak_HashSqueeze, \
+		target##_KeccakWidth1600_12rounds_Sponge, target##_KeccakWidth1600_12rounds_SpongeInitialize, target##_KeccakWidth1600_12rounds_SpongeAbsorb, \
+		target##_KeccakWidth1600_12rounds_SpongeAbsorbLastFewBits, target##_KeccakWidth1600_12rounds_SpongeSqueeze, \
+		PARALLEL(target##_KeccakP1600times4), PARALLEL(target##_KeccakP1600times8) \
+	};
+
+static int generic64_supported(){
+	return 1;
+}
+
+static int avx2_supported(){
+	return __builtin_cpu_supports("avx2");
+}
+
+static int avx512_supported(){
+	return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vl");
+}
+
+// generic64: plain 64-bit C, the parallel permutations are one lane after the other
+// Haswell: AVX2 single-lane permutation, 4-way AVX2 permutation and the 8-way one as two 4-way calls
+// SkylakeX: AVX-512 single-lane permutation, 4-way and 8-way AVX-512 permutations
+BACKEND(generic64, generic64_supported)
+BACKEND(Haswell, avx2_supported)
+BACKEND(SkylakeX, avx512_supported)
+
+// fastest first, the last one runs on every x86-64 CPU
+static const keccak_backend *const backends[] = {&SkylakeX_backend, &Haswell_backend, &generic64_backend};
+#define BACKENDS (sizeof(backends)/sizeof(backends[0]))
+
+const keccak_backend *keccak_selected = &generic64_backend;
+
+__attribute__((constructor))
+static void keccak_select(){
+	__builtin_cpu_init();
+	const char *forced = getenv("KECCAK_BACKEND");
+	for (size_t b = 0; b < BACKENDS; ++b)
+	{
+		if (backends[b]->supported() && (forced == NULL || strcmp(forced, backends[b]->name) == 0)){
+			keccak_selected = backends[b];
+			return;
+		}
+	}
+}
+
+// the functions of SimpleFIPS202.h and KeccakHash.h that the scheme and the group actions call, for whichever backend is selected
+
+int SHAKE128(unsigned char *output, size_t outputByteLen, const unsigned char *input, size_t inputByteLen){
+	return keccak_selected->shake128(output, outputByteLen, input, inputByteLen);
+}
+
+HashReturn Keccak_HashInitialize(Keccak_HashInstance *hashInstance, unsigned int rate, unsigned int capacity, unsigned int hashbitlen, unsigned char delimitedSuffix){
+	return keccak_selected->hash_initialize(hashInstance, rate, capacity, hashbitlen, delimitedSuffix);
+}
+
+HashReturn Keccak_HashUpdate(Keccak_HashInstance *hashInstance, const BitSequence *data, BitLength databitlen){
+	return keccak_selected->hash_update(hashInstance, data, databitlen);
+}
+
+HashReturn Keccak_HashFinal(Keccak_HashInstance *hashInstance, BitSequence *hashval){
+	return keccak_selected->hash_final(hashInstance, hashval);
+}
+
+HashReturn Keccak_HashSqueeze(Keccak_HashInstance *hashInstance, BitSequence *data, BitLength databitlen){
+	return keccak_selected->hash_squeeze(hashInstance, data, databitlen);
+}
+
+int KeccakWidth1600_12rounds_Sponge(unsigned int rate, unsigned int capacity, const unsigned char *input, size_t inputByteLen, unsigned char suffix, unsigned char *output, size_t outputByteLen){
+	return keccak_selected->sponge_12rounds(rate, capacity, input, inputByteLen, suffix, output, outputByteLen);
+}
+
+int KeccakWidth1600_12rounds_SpongeInitialize(KeccakWidth1600_12rounds_SpongeInstance *spongeInstance, unsigned int rate, unsigned int capacity){
+	return keccak_selected->sponge_12rounds_initialize(spongeInstance, rate, capacity);
+}
+
+int KeccakWidth1600_12rounds_SpongeAbsorb(KeccakWidth1600_12rounds_SpongeInstance *spongeInstance, const unsigned char *data, size_t dataByteLen){
+	return keccak_selected->sponge_12rounds_absorb(spongeInstance, data, dataByteLen);
+}
+
+int KeccakWidth1600_12rounds_SpongeAbsorbLastFewBits(KeccakWidth1600_12rounds_SpongeInstance *spongeInstance, unsigned char delimitedData){
+	return keccak_selected->sponge_12rounds_absorb_last_few_bits(spongeInstance, delimitedData);
+}
+
+int KeccakWidth1600_12rounds_SpongeSqueeze(KeccakWidth1600_12rounds_SpongeInstance *spongeInstance, unsigned char *data, size_t dataByteLen){
+	return keccak_selected->sponge_12rounds_squeeze(spongeInstance, data, dataByteLen);
+}
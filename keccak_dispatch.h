@@ -0,0 +1,45 @@
+#ifndef KECCAK_DISPATCH_H
+#define KECCAK_DISPATCH_H
+
+#include "libkeccak.a.headers/KeccakHash.h"
+#include "libkeccak.a.headers/SimpleFIPS202.h"
+#include "libkeccak.a.headers/KeccakP-1600-times4-SnP.h"
+#include "libkeccak.a.headers/KeccakP-1600-times8-SnP.h"
+
+// the parallel permutations of a backend, with the states laid out as in XKCP
+typedef struct {
+	void (*initialize_all)(void *states);
+	void (*add_bytes)(void *states, unsigned int instance, const unsigned char *data, unsigned int offset, unsigned int length);
+	void (*permute_all_12rounds)(void *states);
+	void (*permute_all_24rounds)(void *states);
+	void (*extract_bytes)(const void *states, unsigned int instance, unsigned char *data, unsigned int offset, unsigned int length);
+} keccak_parallel;
+
+// one XKCP target, linked with the name of the target in front of all its symbols
+// the sponge and hash contexts are only touched by the backend, they are declared with the headers of the target
+// that has the largest state alignment, so they are large and aligned enough for every backend
+typedef struct {
+	const char *name;
+	int (*supported)(void);
+
+	int (*shake128)(unsigned char *output, size_t outputByteLen, const unsigned char *input, size_t inputByteLen);
+	HashReturn (*hash_initialize)(Keccak_HashInstance *hashInstance, unsigned int rate, unsigned int capacity, unsigned int hashbitlen, unsigned char delimitedSuffix);
+	HashReturn (*hash_update)(Keccak_HashInstance *hashInstance, const BitSequence *data, BitLength databitlen);
+	HashReturn (*hash_final)(Keccak_HashInstance *hashInstance, BitSequence *hashval);
+	HashReturn (*hash_squeeze)(Keccak_HashInstance *hashInstance, BitSequence *data, BitLength databitlen);
+
+	int (*sponge_12rounds)(unsigned int rate, unsigned int capacity, const unsigned char *input, size_t inputByteLen, unsigned char suffix, unsigned char *output, size_t outputByteLen);
+	int (*sponge_12rounds_initialize)(KeccakWidth1600_12rounds_SpongeInstance *spongeInstance, unsigned int rate, unsigned int capacity);
+	int (*sponge_12rounds_absorb)(KeccakWidth1600_12rounds_SpongeInstance *spongeInstance, const unsigned char *data, size_t dataByteLen);
+	int (*sponge_12rounds_absorb_last_few_bits)(KeccakWidth1600_12rounds_SpongeInstance *spongeInstance, unsigned char delimitedData);
+	int (*sponge_12rounds_squeeze)(KeccakWidth1600_12rounds_SpongeInstance *spongeInstance, unsigned char *data, size_t dataByteLen);
+
+	keccak_parallel times4;
+	keccak_parallel times8;
+} keccak_backend;
+
+// picked with CPUID when the program is loaded, the fastest backend the CPU supports
+// KECCAK_BACKEND in the environment picks another supported backend by name, e.g. to compare them
+extern const keccak_backend *keccak_selected;
+
+#endif
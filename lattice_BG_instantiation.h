@@ -1,5 +1,6 @@
 #include "polyvec.h"
 #include "sign.h" // for expand_mat
+#include "parallel.h"
 
 #define BG
 
@@ -25,12 +26,18 @@ static const public_key X0 = {0};
 polyvecl mat[K];
 polyvecl Bmat[K];
 
+// per NUMA node copies of mat and Bmat
+parallel_replica mat_replica;
+parallel_replica Bmat_replica;
+
 #define init_action() { \
 unsigned char matseed[SEEDBYTES] = {0}; \
 /* Expand matrix */ \
 	expand_mat(mat, matseed); \
 	matseed[0] = 1; \
 	expand_mat(Bmat, matseed); \
+	parallel_replicate(&mat_replica, mat, sizeof(mat)); \
+	parallel_replicate(&Bmat_replica, Bmat, sizeof(Bmat)); \
 } 
 
 typedef struct {
@@ -101,8 +108,9 @@ polyvecl_freeze(&out.s); \
 /* Matrix-vector multiplication */ \
 	polyvecl s1hat = g.s; \
 	polyvecl_ntt(&s1hat); \
+	const polyvecl *local_mat = parallel_local(&mat_replica); \
 	for(int i = 0; i < K; ++i) { \
-	polyvecl_pointwise_acc_montgomery(&((*out).vec[i]), &mat[i], &s1hat); \
+	polyvecl_pointwise_acc_montgomery(&((*out).vec[i]), &local_mat[i], &s1hat); \
 	poly_invntt_tomont(&((*out).vec[i])); \
 	} \
 	/* Add error vector s2 */ \
@@ -114,8 +122,9 @@ polyvecl_freeze(&out.s); \
 /* Matrix-vector multiplication */ \
 	polyvecl s1hat = g.s; \
 	polyvecl_ntt(&s1hat); \
+	const polyvecl *local_Bmat = parallel_local(&Bmat_replica); \
 	for(int i = 0; i < K; ++i) { \
-	polyvecl_pointwise_acc_montgomery(&((*out).vec[i]), &Bmat[i], &s1hat); \
+	polyvecl_pointwise_acc_montgomery(&((*out).vec[i]), &local_Bmat[i], &s1hat); \
 	poly_invntt_tomont(&((*out).vec[i])); \
 	} \
 	/* Add error vector e2 */ \
@@ -127,8 +136,9 @@ polyvecl_freeze(&out.s); \
 /* Matrix-vector multiplication */ \
 	polyvecl s1hat = g.s; \
 	polyvecl_ntt(&s1hat); \
+	const polyvecl *local_mat = parallel_local(&mat_replica); \
 	for(int i = 0; i < K; ++i) { \
-	polyvecl_pointwise_acc_montgomery(&((*out).vec[i]), &mat[i], &s1hat); \
+	polyvecl_pointwise_acc_montgomery(&((*out).vec[i]), &local_mat[i], &s1hat); \
 	poly_invntt_tomont(&((*out).vec[i])); \
 	} \
 }
@@ -140,12 +150,19 @@ polyvecl_freeze(&out.s); \
 	polyveck_freeze(&(*out).low); \
 }
 
+#define finish_action_multi(out,in,n,pg) { \
+	for (int multi = 0; multi < (n); ++multi) { \
+		finish_action(&(out)[multi], &(in)[multi], pg); \
+	} \
+}
+
 #define do_tag_action(out, in, g) { \
 /* Matrix-vector multiplication */ \
 	polyvecl s1hat = g.s; \
 	polyvecl_ntt(&s1hat); \
+	const polyvecl *local_Bmat = parallel_local(&Bmat_replica); \
 	for(int i = 0; i < K; ++i) { \
-	polyvecl_pointwise_acc_montgomery(&((*out).all.vec[i]), &Bmat[i], &s1hat); \
+	polyvecl_pointwise_acc_montgomery(&((*out).all.vec[i]), &local_Bmat[i], &s1hat); \
 	poly_invntt_tomont(&((*out).all.vec[i])); \
 	} \
 	polyveck_add(&(*out).all, in, &(*out).all); \
@@ -157,5 +174,18 @@ polyvecl_freeze(&out.s); \
 
 #define is_equal_X(A,B) (memcmp(&(A.high),&(B.high),sizeof(polyveck)) == 0)
 
+// a public key is valid if all its coefficients are reduced mod Q
+static inline int is_valid_pk(const public_key *X){
+	for (int i = 0; i < K; ++i)
+	{
+		for (int j = 0; j < N; ++j)
+		{
+			if ((*X).vec[i].coeffs[j] >= Q)
+				return 0;
+		}
+	}
+	return 1;
+}
+
 #define init_grpelt(g) 
 #define clear_grpelt(g) 
\ No newline at end of file
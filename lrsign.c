@@ -1,262 +1,153 @@
 #include "lrsign.h"
+#include "parallel.h"
 
-#define EXPAND_BUF_LEN (SEED_BYTES*(rings+2))
-#define FM_ROOTS(fm) fm
-#define FM_MESSAGE_HASH(fm) (FM_ROOTS(fm) + HASH_BYTES*EXECUTIONS)
-#define FM_SALT(fm) (FM_MESSAGE_HASH(fm) + HASH_BYTES)
-#define FM_TPRIME(fm) (FM_SALT(fm) + HASH_BYTES)
-#define FM_BYTES (FM_TPRIME(0) + EXECUTIONS*HASH_BYTES)
+// the linkable signatures share their implementation with rsign, the executions also commit to T' and the
+// signature starts with the tag
+
+uint64_t lrsign_workspace_size(const int64_t rings, int threads){
+	return sign_workspace_size(rings, threads, 0, 1);
+}
+
+uint64_t lrsign_lowmem_workspace_size(const int64_t rings, int threads){
+	return sign_workspace_size(rings, threads, 1, 1);
+}
 
 int lrsign(const unsigned char *sk, const int64_t I, const unsigned char *pks, const int64_t rings, const unsigned char *m, uint64_t mlen, unsigned char *sig, uint64_t *sig_len){
-	if (I >= rings || rings > (((uint64_t) 1) << 32))
+	return lrsign_mt(sk, I, pks, rings, m, mlen, sig, sig_len, 1);
+}
+
+int lrsign_mt(const unsigned char *sk, const int64_t I, const unsigned char *pks, const int64_t rings, const unsigned char *m, uint64_t mlen, unsigned char *sig, uint64_t *sig_len, int threads){
+	return lrsign_ws(sk, I, pks, rings, m, mlen, sig, sig_len, threads, NULL);
+}
+
+int lrsign_ws(const unsigned char *sk, const int64_t I, const unsigned char *pks, const int64_t rings, const unsigned char *m, uint64_t mlen, unsigned char *sig, uint64_t *sig_len, int threads, unsigned char *workspace){
+	lrsign_presig presig;
+	if (lrsign_presign(&presig, sk, I, pks, rings, threads, workspace) != 0)
 		return -1;
 
-	int logN = log_round_up(rings);
-	uint64_t rings_round_up = (((uint64_t)1) << logN);
+	return lrsign_finish(&presig, m, mlen, sig, sig_len);
+}
 
-	GRPELTS2 r[EXECUTIONS];
-	for (int i = 0; i < EXECUTIONS; ++i)
-	{
-		init_grpelt(r[i]);
-	}
+int lrsign_prehashed(const unsigned char *sk, const int64_t I, const unsigned char *pks, const int64_t rings, const unsigned char *message_hash, unsigned char *sig, uint64_t *sig_len, int threads, unsigned char *workspace){
+	lrsign_presig presig;
+	if (lrsign_presign(&presig, sk, I, pks, rings, threads, workspace) != 0)
+		return -1;
 
-	unsigned char seed_tree[(2*EXECUTIONS-1)*SEED_BYTES];
-	unsigned char *seeds = seed_tree + (EXECUTIONS-1)*SEED_BYTES;
+	return lrsign_finish_prehashed(&presig, message_hash, sig, sig_len);
+}
 
-	unsigned char seedbuf[SEED_BUF_BYTES];
-	unsigned char expand_buf[EXPAND_BUF_LEN];
-	unsigned char commitments[HASH_BYTES*rings_round_up];
-	unsigned char commitment_randomness[EXECUTIONS*SEED_BYTES];
-	XELT R,Tprime;
-	unsigned char fm[FM_BYTES];
+int lrsign_ctx(const unsigned char *sk, const int64_t I, const ring_ctx *ring, const unsigned char *m, uint64_t mlen, unsigned char *sig, uint64_t *sig_len, int threads, unsigned char *workspace){
+	lrsign_presig presig;
+	if (sign_presign_mode(&presig, sk, I, ring, threads, workspace, 0, 1, NULL) != 0)
+		return -1;
 
-	unsigned char paths[HASH_BYTES*EXECUTIONS*logN];
+	return lrsign_finish(&presig, m, mlen, sig, sig_len);
+}
 
-	// generate response
-	GRPELTS2 z;
-	GRPELTS1L s;
-	init_grpelt(z);
-	init_grpelt(s);
-	sample_S1L(s,sk);
+int lrsign_lowmem(const unsigned char *sk, const int64_t I, const unsigned char *pks, const int64_t rings, const unsigned char *m, uint64_t mlen, unsigned char *sig, uint64_t *sig_len, int threads, unsigned char *workspace){
+	lrsign_presig presig;
+	if (lrsign_presign_lowmem(&presig, sk, I, pks, rings, threads, workspace) != 0)
+		return -1;
 
-	// compute Tag
-	public_key *tag = (public_key *) LRSIG_TAG(sig);
-	derive_tag(tag,s);
+	return lrsign_finish(&presig, m, mlen, sig, sig_len);
+}
 
-	// choose salt
-	RAND_bytes(LRSIG_SALT(sig),HASH_BYTES);
+int lrsign_presign(lrsign_presig *presig, const unsigned char *sk, const int64_t I, const unsigned char *pks, const int64_t rings, int threads, unsigned char *workspace){
+	ring_ctx ring;
+	ring_ctx_view(&ring, pks, rings);
+	return sign_presign_mode(presig, sk, I, &ring, threads, workspace, 0, 1, NULL);
+}
 
-	// copy salt
-	memcpy(FM_SALT(fm), LRSIG_SALT(sig), HASH_BYTES);
-	memcpy(seedbuf + SEED_BYTES, LRSIG_SALT(sig), HASH_BYTES);
-	uint32_t *ctr = (uint32_t *) (seedbuf + HASH_BYTES + SEED_BYTES);
+int lrsign_presign_lowmem(lrsign_presig *presig, const unsigned char *sk, const int64_t I, const unsigned char *pks, const int64_t rings, int threads, unsigned char *workspace){
+	ring_ctx ring;
+	ring_ctx_view(&ring, pks, rings);
+	return sign_presign_mode(presig, sk, I, &ring, threads, workspace, 1, 1, NULL);
+}
 
-	unsigned char zero_seed[SEED_BYTES] = {0};
+int lrsign_controlled(const unsigned char *sk, const int64_t I, const unsigned char *pks, const int64_t rings, const unsigned char *message_hash, unsigned char *sig, uint64_t *sig_len, int threads, parallel_control *control){
+	ring_ctx ring;
+	ring_ctx_view(&ring, pks, rings);
 
-	// pick random seeds
-	restart: generate_seed_tree(seed_tree,EXECUTIONS,LRSIG_SALT(sig));
+	lrsign_presig presig;
+	if (sign_presign_mode(&presig, sk, I, &ring, threads, NULL, 0, 1, control) != 0)
+		return -1;
 
-	// hash message
-	HASH(m,mlen,FM_MESSAGE_HASH(fm));
-
-	for (int i = 0; i < EXECUTIONS; ++i)
-	{
-		// generate commitment randomness and r
-		memcpy(seedbuf, seeds + i*SEED_BYTES, SEED_BYTES);
-		(*ctr)  = EXECUTIONS + i; 
-		EXPAND(seedbuf, SEED_BUF_BYTES, expand_buf, EXPAND_BUF_LEN);
-
-		// sample r
-		sample_S2_with_seed(expand_buf + SEED_BYTES*rings, r[i]);
-
-		PREP_GRPELT pg;
-		do_half_action(&pg,r[i]);
-
-		// Memory access at secret location!
-		memcpy(commitment_randomness + i*SEED_BYTES , expand_buf + I*SEED_BYTES , SEED_BYTES);
-
-		// compute and commit to T'
-		do_tag_action(&Tprime,tag,r[i]);
-		commit(&Tprime, zero_seed , RSIG_SALT(sig), FM_TPRIME(fm) + i*HASH_BYTES);
-
-		// compute R_i and commitments
-		for (int j = 0; j < rings; ++j)
-		{
-			finish_action(&R,(public_key*) (pks + j*sizeof(public_key)), &pg);
-			commit(&R,expand_buf + j*SEED_BYTES, RSIG_SALT(sig), commitments + j*HASH_BYTES);
-		}
-
-		// generate dummy commitments
-		EXPAND(expand_buf + SEED_BYTES * (rings +1), SEED_BYTES, commitments + rings*HASH_BYTES, (rings_round_up-rings)*HASH_BYTES);
-
-		build_tree_and_path(commitments, logN, I, FM_ROOTS(fm) + i*HASH_BYTES, paths + i*HASH_BYTES*logN );
-	}
-
-	// generate challenge
-	EXPAND(fm, FM_BYTES, LRSIG_CHALLENGE(sig), SEED_BYTES);
-	unsigned char challenge[EXECUTIONS];
-	derive_challenge(LRSIG_CHALLENGE(sig),challenge);
-
-	int zeros = 0;
-	int ones = 0;
-	for (int i = 0; i < EXECUTIONS; ++i)
-	{
-		if (challenge[i] == 0)
-		{
-			// compute and pack z in signature
-			add(z, s, r[i]);
-			if( !is_in_S3(z) ){
-				restarts += 1;
-				goto restart;
-			}
-
-			#ifdef BG
-			XELT W;
-			do_action(&W,&X0,z);
-			if( !bg_check(&W) ){
-				restarts += 1;
-				goto restart;
-			}
-			do_tag_action(&W,&X0,z);
-			if( !bg_check(&W) ){
-				restarts += 1;
-				goto restart;
-			}
-			#endif
-
-			pack_S3(LRSIG_Z(sig) + zeros*S3_BYTES, z);
-
-			// copy commitment randomess to signature
-			memcpy(LRSIG_COMMITMENT_RANDOMNESS(sig) + zeros*SEED_BYTES, commitment_randomness + i*SEED_BYTES, SEED_BYTES);
-			// copy Merkle tree path to signature
-			memcpy(LRSIG_PATHS(sig) + zeros*logN*HASH_BYTES, paths + i*HASH_BYTES*logN, HASH_BYTES*logN);
-			zeros++;
-		}
-	}
-
-	release_seeds(seed_tree, EXECUTIONS, challenge, LRSIG_SEEDS(sig,logN) , sig_len );
-	(*sig_len) *= SEED_BYTES;
-	(*sig_len) += LRSIG_SEEDS(0,logN);
-
-	for (int i = 0; i < EXECUTIONS; ++i)
-	{
-		clear_grpelt(r[i]);
-	}
-
-	clear_grpelt(z);
-	clear_grpelt(s);
+	return lrsign_finish_prehashed(&presig, message_hash, sig, sig_len);
+}
+
+int lrsign_finish(lrsign_presig *presig, const unsigned char *m, uint64_t mlen, unsigned char *sig, uint64_t *sig_len){
+	return rsign_finish(presig, m, mlen, sig, sig_len);
+}
+
+int lrsign_finish_prehashed(lrsign_presig *presig, const unsigned char *message_hash, unsigned char *sig, uint64_t *sig_len){
+	return rsign_finish_prehashed(presig, message_hash, sig, sig_len);
+}
+
+int lrsign_speculative(const unsigned char *sk, const int64_t I, const unsigned char *pks, const int64_t rings, const unsigned char *m, uint64_t mlen, unsigned char *sig, uint64_t *sig_len, int threads, int candidates){
+	ring_ctx ring;
+	ring_ctx_view(&ring, pks, rings);
+	return sign_speculative(sk, I, &ring, m, mlen, sig, sig_len, threads, candidates, 1);
+}
+
+void lrsign_presig_clear(lrsign_presig *presig){
+	rsign_presig_clear(presig);
+}
+
+uint64_t lrverify_workspace_size(const int64_t rings, int threads){
+	return verify_workspace_size(rings, threads, 1);
 }
 
 int  lrverify(const unsigned char *pks, const int64_t rings, const unsigned char *m, uint64_t mlen, const unsigned char *sig){
-	if (rings > (((uint64_t) 1) << 32))
-		return -1;
+	return lrverify_mt(pks, rings, m, mlen, sig, 1);
+}
+
+int  lrverify_mt(const unsigned char *pks, const int64_t rings, const unsigned char *m, uint64_t mlen, const unsigned char *sig, int threads){
+	return lrverify_ws(pks, rings, m, mlen, sig, threads, NULL);
+}
+
+int  lrverify_ws(const unsigned char *pks, const int64_t rings, const unsigned char *m, uint64_t mlen, const unsigned char *sig, int threads, unsigned char *workspace){
+	// hash message
+	unsigned char message_hash[HASH_BYTES];
+	HASH(m,mlen,message_hash);
 
-	int valid = 0;
+	return lrverify_prehashed(pks, rings, message_hash, sig, threads, workspace);
+}
 
-	int logN = log_round_up(rings);
-	uint64_t rings_round_up = (((uint64_t)1) << logN);
+int  lrverify_prehashed(const unsigned char *pks, const int64_t rings, const unsigned char *message_hash, const unsigned char *sig, int threads, unsigned char *workspace){
+	ring_ctx ring;
+	ring_ctx_view(&ring, pks, rings);
+	return verify_run(&ring, message_hash, sig, threads, workspace, NULL, NULL, 1);
+}
 
-	// expand challenge
-	unsigned char challenge[EXECUTIONS];
-	derive_challenge(LRSIG_CHALLENGE(sig),challenge);
+int  lrverify_controlled(const unsigned char *pks, const int64_t rings, const unsigned char *message_hash, const unsigned char *sig, int threads, parallel_control *control){
+	ring_ctx ring;
+	ring_ctx_view(&ring, pks, rings);
+	return verify_run(&ring, message_hash, sig, threads, NULL, control, NULL, 1);
+}
 
-	// derive seeds
-	unsigned char seed_tree[(2*EXECUTIONS-1)*SEED_BYTES];
-	unsigned char *seeds = seed_tree + (EXECUTIONS-1)*SEED_BYTES;
-	uint64_t nodes_used;
-	fill_down(seed_tree,EXECUTIONS, challenge, LRSIG_SEEDS(sig,logN), &nodes_used, LRSIG_SALT(sig));
+int  lrverify_bounded(const unsigned char *pks, const int64_t rings, const unsigned char *m, uint64_t mlen, const unsigned char *sig, uint64_t sig_len, int threads, const verify_budget *budget){
+	unsigned char message_hash[HASH_BYTES];
+	HASH(m,mlen,message_hash);
 
-	unsigned char fm[FM_BYTES];
+	return lrverify_bounded_prehashed(pks, rings, message_hash, sig, sig_len, threads, budget);
+}
 
+int  lrverify_bounded_prehashed(const unsigned char *pks, const int64_t rings, const unsigned char *message_hash, const unsigned char *sig, uint64_t sig_len, int threads, const verify_budget *budget){
+	ring_ctx ring;
+	ring_ctx_view(&ring, pks, rings);
+	return verify_bounded_prehashed(&ring, message_hash, sig, sig_len, threads, budget, 1);
+}
+
+int  lrverify_ctx(const ring_ctx *ring, const unsigned char *m, uint64_t mlen, const unsigned char *sig, int threads, unsigned char *workspace){
 	// hash message
-	HASH(m,mlen,FM_MESSAGE_HASH(fm))
-
-	// copy salt
-	memcpy(FM_SALT(fm), LRSIG_SALT(sig), HASH_BYTES);
-
-	public_key *tag = (public_key *) LRSIG_TAG(sig);
-	unsigned char zero_seed[SEED_BYTES] = {0};
-
-	int zeros = 0;
-	int ones = 0;
-	GRPELTS2 r,z;
-	XELT R,Tprime;
-	init_grpelt(r);
-	init_grpelt(z);
-
-	unsigned char expand_buf[EXPAND_BUF_LEN];
-	unsigned char seedbuf[SEED_BUF_BYTES];
-	memcpy(seedbuf + SEED_BYTES, LRSIG_SALT(sig) , HASH_BYTES);
-	uint32_t *ctr = (uint32_t *) (seedbuf + SEED_BYTES + HASH_BYTES);
-
-	unsigned char commitments[HASH_BYTES*rings_round_up];
-	for (int i = 0; i < EXECUTIONS; ++i)
-	{
-		if (challenge[i] == 0){
-			// unpack z
-			unpack_S3(LRSIG_Z(sig) + zeros*S3_BYTES, z);
-
-			if(!is_in_S3(z)){
-				printf("z not in S3! \n");
-				valid = -1;
-				break;
-			}
-
-			// compute z * X_0 and z \bullet T_0 
-			do_action(&R,&X0,z);
-
-			do_tag_action(&Tprime,&X0,z);
-			commit(&Tprime, zero_seed , RSIG_SALT(sig), FM_TPRIME(fm) + i*HASH_BYTES);
-
-			// commit to it
-			commit(&R,LRSIG_COMMITMENT_RANDOMNESS(sig) + SEED_BYTES*zeros, RSIG_SALT(sig), commitments);
-			// reconstruct root
-			reconstruct_root(commitments, LRSIG_PATHS(sig) + zeros*logN*HASH_BYTES, logN, FM_ROOTS(fm) + i*HASH_BYTES);
-			zeros++;
-		}
-		else{
-			// generate commitment randomness and r
-			memcpy(seedbuf, seeds + i*SEED_BYTES, SEED_BYTES);
-			(*ctr)  = EXECUTIONS + i; 
-			EXPAND(seedbuf, SEED_BUF_BYTES, expand_buf, EXPAND_BUF_LEN);
-
-			// sample r
-			sample_S2_with_seed(expand_buf + SEED_BYTES*rings, r);
-
-			PREP_GRPELT pg;
-			do_half_action(&pg,r);
-
-			// compute and commit to T'
-			do_tag_action(&Tprime,tag,r);
-			commit(&Tprime, zero_seed , RSIG_SALT(sig), FM_TPRIME(fm) + i*HASH_BYTES);
-
-			// compute R_i and commitments
-			for (int j = 0; j < rings; ++j)
-			{
-				finish_action(&R, (public_key*) (pks + j*sizeof(public_key)), &pg);
-				commit(&R,expand_buf + j*SEED_BYTES, RSIG_SALT(sig), commitments + j*HASH_BYTES);
-			}
-
-			// generate dummy commitments
-			EXPAND(expand_buf + SEED_BYTES * (rings +1), SEED_BYTES, commitments + rings*HASH_BYTES, (rings_round_up-rings)*HASH_BYTES);
-
-			// compute root
-			build_tree_and_path(commitments, logN, -1 , FM_ROOTS(fm) + i*HASH_BYTES, NULL );
-			ones++;
-		}
-	}
-
-	clear_grpelt(r);
-	clear_grpelt(z);
-
-	// check hash of first message
-	unsigned char challenge_seed[SEED_BYTES];
-	EXPAND(fm, FM_BYTES, challenge_seed, SEED_BYTES);
-
-	if(memcmp(LRSIG_CHALLENGE(sig) , challenge_seed, SEED_BYTES) != 0){
-		printf("challenge seed does not match! \n");
-		return -1;
-	}
+	unsigned char message_hash[HASH_BYTES];
+	HASH(m,mlen,message_hash);
 
-	return valid;
-}
\ No newline at end of file
+	return verify_run(ring, message_hash, sig, threads, workspace, NULL, NULL, 1);
+}
+
+int  lrverify_batch(const unsigned char *pks, const int64_t rings, const unsigned char *const *ms, const uint64_t *mlens, const unsigned char *const *sigs, int count, int *results, int threads){
+	ring_ctx ring;
+	ring_ctx_view(&ring, pks, rings);
+	return verify_batch(&ring, ms, mlens, sigs, count, results, threads, 1);
+}
@@ -6,7 +6,8 @@
 #include "stdint.h"
 
 #define LRSIG_TAG(sig) (sig) 
-#define LRSIG_SALT(sig) (LRSIG_TAG(sig) + PK_BYTES )
+#define LRSIG_FORMAT(sig) (LRSIG_TAG(sig) + PK_BYTES )
+#define LRSIG_SALT(sig) (LRSIG_FORMAT(sig) + 1)
 #define LRSIG_CHALLENGE(sig) (LRSIG_SALT(sig) + HASH_BYTES)
 #define LRSIG_Z(sig) (LRSIG_CHALLENGE(sig) + SEED_BYTES)
 #define LRSIG_COMMITMENT_RANDOMNESS(sig) (LRSIG_Z(sig) + S3_BYTES*ZEROS)
@@ -14,7 +15,36 @@
 #define LRSIG_SEEDS(sig, logN) (LRSIG_PATHS(sig) + logN*HASH_BYTES*ZEROS )
 #define LRSIG_BYTES(logN) (LRSIG_SEEDS(0,logN) + SEED_BYTES*ONES)
 
+// a linkable presignature is an rsign_presig that also keeps the tag
+typedef rsign_presig lrsign_presig;
+
 int lrsign(const unsigned char *sk_I, const int64_t I, const unsigned char *pks, const int64_t ring_size, const unsigned char *m, uint64_t mlen, unsigned char *sig, uint64_t *sig_len);
+int lrsign_mt(const unsigned char *sk_I, const int64_t I, const unsigned char *pks, const int64_t ring_size, const unsigned char *m, uint64_t mlen, unsigned char *sig, uint64_t *sig_len, int threads);
+int lrsign_ws(const unsigned char *sk_I, const int64_t I, const unsigned char *pks, const int64_t ring_size, const unsigned char *m, uint64_t mlen, unsigned char *sig, uint64_t *sig_len, int threads, unsigned char *workspace);
+int lrsign_lowmem(const unsigned char *sk_I, const int64_t I, const unsigned char *pks, const int64_t ring_size, const unsigned char *m, uint64_t mlen, unsigned char *sig, uint64_t *sig_len, int threads, unsigned char *workspace);
+int lrsign_speculative(const unsigned char *sk_I, const int64_t I, const unsigned char *pks, const int64_t ring_size, const unsigned char *m, uint64_t mlen, unsigned char *sig, uint64_t *sig_len, int threads, int candidates);
+int lrsign_prehashed(const unsigned char *sk_I, const int64_t I, const unsigned char *pks, const int64_t ring_size, const unsigned char *message_hash, unsigned char *sig, uint64_t *sig_len, int threads, unsigned char *workspace);
+int lrsign_controlled(const unsigned char *sk_I, const int64_t I, const unsigned char *pks, const int64_t ring_size, const unsigned char *message_hash, unsigned char *sig, uint64_t *sig_len, int threads, parallel_control *control);
+int lrsign_ctx(const unsigned char *sk_I, const int64_t I, const ring_ctx *ring, const unsigned char *m, uint64_t mlen, unsigned char *sig, uint64_t *sig_len, int threads, unsigned char *workspace);
+int lrsign_presign(lrsign_presig *presig, const unsigned char *sk_I, const int64_t I, const unsigned char *pks, const int64_t ring_size, int threads, unsigned char *workspace);
+int lrsign_presign_lowmem(lrsign_presig *presig, const unsigned char *sk_I, const int64_t I, const unsigned char *pks, const int64_t ring_size, int threads, unsigned char *workspace);
+int lrsign_finish(lrsign_presig *presig, const unsigned char *m, uint64_t mlen, unsigned char *sig, uint64_t *sig_len);
+int lrsign_finish_prehashed(lrsign_presig *presig, const unsigned char *message_hash, unsigned char *sig, uint64_t *sig_len);
+void lrsign_presig_clear(lrsign_presig *presig);
 int  lrverify(const unsigned char *pks, const int64_t ring_size, const unsigned char *m, uint64_t mlen, const unsigned char *sig);
+int  lrverify_mt(const unsigned char *pks, const int64_t ring_size, const unsigned char *m, uint64_t mlen, const unsigned char *sig, int threads);
+int  lrverify_ws(const unsigned char *pks, const int64_t ring_size, const unsigned char *m, uint64_t mlen, const unsigned char *sig, int threads, unsigned char *workspace);
+int  lrverify_prehashed(const unsigned char *pks, const int64_t ring_size, const unsigned char *message_hash, const unsigned char *sig, int threads, unsigned char *workspace);
+int  lrverify_controlled(const unsigned char *pks, const int64_t ring_size, const unsigned char *message_hash, const unsigned char *sig, int threads, parallel_control *control);
+int  lrverify_ctx(const ring_ctx *ring, const unsigned char *m, uint64_t mlen, const unsigned char *sig, int threads, unsigned char *workspace);
+int  lrverify_batch(const unsigned char *pks, const int64_t ring_size, const unsigned char *const *ms, const uint64_t *mlens, const unsigned char *const *sigs, int count, int *results, int threads);
+int  lrverify_bounded(const unsigned char *pks, const int64_t ring_size, const unsigned char *m, uint64_t mlen, const unsigned char *sig, uint64_t sig_len, int threads, const verify_budget *budget);
+int  lrverify_bounded_prehashed(const unsigned char *pks, const int64_t ring_size, const unsigned char *message_hash, const unsigned char *sig, uint64_t sig_len, int threads, const verify_budget *budget);
+
+// size of the workspace that lrsign_ws/lrsign_presign and lrverify_ws need for a ring of ring_size members
+uint64_t lrsign_workspace_size(const int64_t ring_size, int threads);
+// the same for lrsign_lowmem/lrsign_presign_lowmem, which only keep r_i and the paths of the opened executions
+uint64_t lrsign_lowmem_workspace_size(const int64_t ring_size, int threads);
+uint64_t lrverify_workspace_size(const int64_t ring_size, int threads);
 
 #endif
@@ -0,0 +1,488 @@
+#define _GNU_SOURCE
+#include "parallel.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// a slot is the share of a job of one logical thread, its remaining indices [lo,hi) are packed in one word
+// the owner takes indices from the front, thieves take the back half
+typedef struct {
+	atomic_uint_fast64_t range;
+} parallel_slot;
+
+typedef struct parallel_job {
+	parallel_task task;
+	void *arg;
+	int64_t count;
+	int threads;
+	parallel_control *control;
+	parallel_slot *slots;
+
+	// protected by the pool lock
+	int claimed;
+	int running;
+	struct parallel_job *next;
+} parallel_job;
+
+typedef struct {
+	pthread_mutex_t lock;
+	pthread_cond_t work;
+	pthread_cond_t done;
+	parallel_job *head;
+	parallel_job *tail;
+	int workers;
+	int stopping;
+	int pin;
+	pthread_t ids[PARALLEL_MAX_WORKERS];
+} parallel_pool;
+
+static parallel_pool pool = {PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, PTHREAD_COND_INITIALIZER};
+
+// cpus allowed to the process ordered by node, and the node of every cpu
+static pthread_once_t topology_once = PTHREAD_ONCE_INIT;
+static int topology_nodes = 1;
+static int topology_cpus = 0;
+static int topology_order[PARALLEL_MAX_CPUS];
+static int topology_node_of[PARALLEL_MAX_CPUS];
+
+static _Thread_local int current_node = -1;
+
+#define RANGE(lo, hi) (((uint64_t) (hi) << 32) | (uint64_t) (lo))
+#define RANGE_LO(r) ((int64_t) ((r) & 0xffffffff))
+#define RANGE_HI(r) ((int64_t) ((r) >> 32))
+
+static void read_topology(void){
+	for (int cpu = 0; cpu < PARALLEL_MAX_CPUS; ++cpu)
+	{
+		topology_node_of[cpu] = 0;
+	}
+
+	// cpulist files look like "0-15,32-47"
+	int nodes = 0;
+	for (int node = 0; node < PARALLEL_MAX_NODES; ++node)
+	{
+		char path[64];
+		snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+		FILE *f = fopen(path, "r");
+		if (f == NULL)
+			break;
+
+		int lo, hi;
+		while (fscanf(f, "%d", &lo) == 1){
+			hi = lo;
+			int c = fgetc(f);
+			if (c == '-'){
+				if (fscanf(f, "%d", &hi) != 1)
+					break;
+				c = fgetc(f);
+			}
+			for (int cpu = lo; cpu <= hi && cpu < PARALLEL_MAX_CPUS; ++cpu)
+			{
+				topology_node_of[cpu] = node;
+			}
+			if (c != ',')
+				break;
+		}
+		fclose(f);
+		nodes++;
+	}
+	topology_nodes = nodes > 0 ? nodes : 1;
+
+	cpu_set_t allowed;
+	CPU_ZERO(&allowed);
+	if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
+		return;
+
+	for (int node = 0; node < topology_nodes; ++node)
+	{
+		for (int cpu = 0; cpu < PARALLEL_MAX_CPUS && cpu < CPU_SETSIZE; ++cpu)
+		{
+			if (CPU_ISSET(cpu, &allowed) && topology_node_of[cpu] == node)
+				topology_order[topology_cpus++] = cpu;
+		}
+	}
+}
+
+int parallel_nodes(void){
+	pthread_once(&topology_once, read_topology);
+	return topology_nodes;
+}
+
+int parallel_current_node(void){
+	if (current_node >= 0)
+		return current_node;
+
+	// threads that are not pinned may move, so their node is looked up every time
+	pthread_once(&topology_once, read_topology);
+	int cpu = sched_getcpu();
+	if (cpu < 0 || cpu >= PARALLEL_MAX_CPUS)
+		return 0;
+	return topology_node_of[cpu];
+}
+
+static void pin_to_cpu(int cpu){
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0)
+		current_node = topology_node_of[cpu];
+}
+
+static int take_index(parallel_slot *slot, int64_t *index){
+	uint64_t range = atomic_load(&slot->range);
+	while (RANGE_LO(range) < RANGE_HI(range)){
+		if (atomic_compare_exchange_weak(&slot->range, &range, RANGE(RANGE_LO(range) + 1, RANGE_HI(range)))){
+			*index = RANGE_LO(range);
+			return 1;
+		}
+	}
+	return 0;
+}
+
+// moves the back half of the fullest other slot into the (empty) slot of thread
+static int steal(parallel_job *job, int thread){
+	while (1){
+		int victim = -1;
+		int64_t most = 0;
+		for (int t = 0; t < job->threads; ++t)
+		{
+			uint64_t range = atomic_load(&job->slots[t].range);
+			int64_t left = RANGE_HI(range) - RANGE_LO(range);
+			if (t != thread && left > most){
+				most = left;
+				victim = t;
+			}
+		}
+		if (victim < 0)
+			return 0;
+
+		uint64_t range = atomic_load(&job->slots[victim].range);
+		int64_t lo = RANGE_LO(range), hi = RANGE_HI(range);
+		if (lo >= hi)
+			continue;
+
+		int64_t mid = lo + (hi - lo)/2;
+		if (atomic_compare_exchange_strong(&job->slots[victim].range, &range, RANGE(lo, mid))){
+			atomic_store(&job->slots[thread].range, RANGE(mid, hi));
+			return 1;
+		}
+	}
+}
+
+static void control_completed(parallel_control *control){
+	for (; control != NULL; control = control->parent)
+	{
+		atomic_fetch_add(&control->completed, 1);
+	}
+}
+
+static void run_slot(parallel_job *job, int thread){
+	int64_t i;
+	do {
+		while (take_index(&job->slots[thread], &i)){
+			// once cancelled, the remaining indices are skipped
+			if (parallel_cancelled(job->control))
+				return;
+
+			job->task(job->arg, i, thread);
+
+			control_completed(job->control);
+		}
+	} while (steal(job, thread));
+}
+
+static void *run_worker(void *in){
+	int worker = (int) (intptr_t) in;
+
+	if (pool.pin && topology_cpus > 0){
+		// the caller of the first job is usually on the first cpu, so worker w goes to cpu w+1
+		pin_to_cpu(topology_order[(worker + 1) % topology_cpus]);
+	}
+
+	pthread_mutex_lock(&pool.lock);
+	while (1){
+		while (pool.head == NULL && !pool.stopping)
+			pthread_cond_wait(&pool.work, &pool.lock);
+		if (pool.head == NULL)
+			break;
+
+		parallel_job *job = pool.head;
+		int thread = job->claimed++;
+		if (job->claimed == job->threads){
+			pool.head = job->next;
+			if (pool.head == NULL)
+				pool.tail = NULL;
+		}
+		job->running++;
+		pthread_mutex_unlock(&pool.lock);
+
+		run_slot(job, thread);
+
+		pthread_mutex_lock(&pool.lock);
+		if (--job->running == 0)
+			pthread_cond_broadcast(&pool.done);
+	}
+	pthread_mutex_unlock(&pool.lock);
+	return NULL;
+}
+
+// called with the pool lock held
+static void grow_pool(int workers){
+	if (workers > PARALLEL_MAX_WORKERS)
+		workers = PARALLEL_MAX_WORKERS;
+
+	pthread_once(&topology_once, read_topology);
+	while (pool.workers < workers && !pool.stopping){
+		if (pthread_create(&pool.ids[pool.workers], NULL, run_worker, (void *) (intptr_t) pool.workers) != 0)
+			break;
+		pool.workers++;
+	}
+}
+
+int parallel_pool_start(int workers, int pin){
+	pthread_mutex_lock(&pool.lock);
+	pool.stopping = 0;
+	if (pool.workers == 0)
+		pool.pin = pin;
+	grow_pool(workers);
+	int started = pool.workers;
+	pthread_mutex_unlock(&pool.lock);
+	return started;
+}
+
+void parallel_pool_stop(void){
+	pthread_mutex_lock(&pool.lock);
+	pool.stopping = 1;
+	pthread_cond_broadcast(&pool.work);
+	int workers = pool.workers;
+	pthread_mutex_unlock(&pool.lock);
+
+	for (int w = 0; w < workers; ++w)
+	{
+		pthread_join(pool.ids[w], NULL);
+	}
+
+	// the next parallel_for starts a new pool
+	pthread_mutex_lock(&pool.lock);
+	pool.workers = 0;
+	pool.stopping = 0;
+	pthread_mutex_unlock(&pool.lock);
+}
+
+void parallel_control_init(parallel_control *control){
+	parallel_control_init_child(control, NULL);
+}
+
+void parallel_control_init_child(parallel_control *control, parallel_control *parent){
+	atomic_init(&control->cancelled, 0);
+	atomic_init(&control->completed, 0);
+	atomic_init(&control->cycles, 0);
+	control->parent = parent;
+	control->limit = NULL;
+	control->limit_arg = NULL;
+}
+
+void parallel_cancel(parallel_control *control){
+	atomic_store(&control->cancelled, 1);
+}
+
+int parallel_cancelled(parallel_control *control){
+	for (; control != NULL; control = control->parent)
+	{
+		if (atomic_load(&control->cancelled))
+			return 1;
+		if (control->limit != NULL && control->limit(control->limit_arg, atomic_load(&control->cycles))){
+			parallel_cancel(control);
+			return 1;
+		}
+	}
+	return 0;
+}
+
+void parallel_charge(parallel_control *control, uint64_t cycles){
+	if (control != NULL)
+		atomic_fetch_add(&control->cycles, cycles);
+}
+
+void parallel_for(int threads, int64_t count, parallel_task task, void *arg){
+	parallel_for_control(threads, count, task, arg, NULL);
+}
+
+void parallel_for_control(int threads, int64_t count, parallel_task task, void *arg, parallel_control *control){
+	if (threads > count)
+		threads = count;
+	// the ranges are packed in 32 bit halves
+	if (count > UINT32_MAX)
+		threads = 1;
+	if (threads < 1)
+		threads = 1;
+
+	if (threads == 1){
+		for (int64_t i = 0; i < count && !parallel_cancelled(control); ++i)
+		{
+			task(arg, i, 0);
+			control_completed(control);
+		}
+		return;
+	}
+
+	// every thread starts with a contiguous block of indices
+	parallel_slot slots[threads];
+	for (int t = 0; t < threads; ++t)
+	{
+		atomic_init(&slots[t].range, RANGE(count*t/threads, count*(t + 1)/threads));
+	}
+
+	parallel_job job;
+	job.task = task;
+	job.arg = arg;
+	job.count = count;
+	job.threads = threads;
+	job.control = control;
+	job.slots = slots;
+	job.claimed = 1;
+	job.running = 0;
+	job.next = NULL;
+
+	pthread_mutex_lock(&pool.lock);
+	grow_pool(threads - 1);
+	if (pool.workers > 0 && !pool.stopping){
+		if (pool.tail != NULL)
+			pool.tail->next = &job;
+		else
+			pool.head = &job;
+		pool.tail = &job;
+		pthread_cond_broadcast(&pool.work);
+	}
+	pthread_mutex_unlock(&pool.lock);
+
+	// the calling thread is thread 0, it steals the work of slots no worker got to
+	run_slot(&job, 0);
+
+	pthread_mutex_lock(&pool.lock);
+	if (job.claimed < job.threads){
+		job.claimed = job.threads;
+		parallel_job **link = &pool.head;
+		parallel_job *prev = NULL;
+		while (*link != NULL && *link != &job){
+			prev = *link;
+			link = &(*link)->next;
+		}
+		if (*link == &job){
+			*link = job.next;
+			if (pool.tail == &job)
+				pool.tail = prev;
+		}
+	}
+	while (job.running > 0)
+		pthread_cond_wait(&pool.done, &pool.lock);
+	pthread_mutex_unlock(&pool.lock);
+}
+
+typedef struct {
+	int (*fn)(void *arg, int node);
+	void *arg;
+	int node;
+	int result;
+} node_call;
+
+static void *call_on_node(void *in){
+	node_call *call = (node_call *) in;
+	call->result = call->fn(call->arg, call->node);
+	return NULL;
+}
+
+int parallel_on_nodes(int (*fn)(void *arg, int node), void *arg){
+	int nodes = parallel_nodes();
+	for (int node = 0; node < nodes; ++node)
+	{
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		for (int c = 0; c < topology_cpus; ++c)
+		{
+			if (topology_node_of[topology_order[c]] == node)
+				CPU_SET(topology_order[c], &set);
+		}
+
+		node_call call = {fn, arg, node, 0};
+		pthread_attr_t attr;
+		pthread_t id;
+		pthread_attr_init(&attr);
+		pthread_attr_setaffinity_np(&attr, sizeof(set), &set);
+		if (pthread_create(&id, &attr, call_on_node, &call) == 0)
+			pthread_join(id, NULL);
+		else
+			call_on_node(&call);
+		pthread_attr_destroy(&attr);
+
+		if (call.result != 0)
+			return -1;
+	}
+	return 0;
+}
+
+typedef struct {
+	parallel_replica *replica;
+	const void *src;
+	size_t size;
+} replicate_job;
+
+static int replicate_on_node(void *arg, int node){
+	replicate_job *job = (replicate_job *) arg;
+
+	// the pages end up on the node of the thread that touches them first
+	size_t size = (job->size + PARALLEL_REPLICA_ALIGN - 1)/PARALLEL_REPLICA_ALIGN*PARALLEL_REPLICA_ALIGN;
+	void *copy = aligned_alloc(PARALLEL_REPLICA_ALIGN, size);
+	if (copy == NULL)
+		return -1;
+	memcpy(copy, job->src, job->size);
+	job->replica->copies[node] = copy;
+	return 0;
+}
+
+int parallel_replicate(parallel_replica *replica, const void *src, size_t size){
+	int nodes = parallel_nodes();
+	replica->nodes = nodes;
+	replica->owned = 0;
+	for (int node = 0; node < PARALLEL_MAX_NODES; ++node)
+	{
+		replica->copies[node] = (void *) src;
+	}
+	if (nodes == 1)
+		return 0;
+
+	// copies that are not made yet are NULL, so a failure only frees the ones that were made
+	replica->owned = 1;
+	for (int node = 0; node < nodes; ++node)
+	{
+		replica->copies[node] = NULL;
+	}
+	replicate_job job = {replica, src, size};
+	if (parallel_on_nodes(replicate_on_node, &job) != 0){
+		parallel_replica_free(replica);
+		return -1;
+	}
+	return 0;
+}
+
+const void *parallel_local(const parallel_replica *replica){
+	if (replica->nodes <= 1)
+		return replica->copies[0];
+
+	int node = parallel_current_node();
+	return replica->copies[node < replica->nodes ? node : 0];
+}
+
+void parallel_replica_free(parallel_replica *replica){
+	for (int node = 0; node < PARALLEL_MAX_NODES; ++node)
+	{
+		if (replica->owned && node < replica->nodes)
+			free(replica->copies[node]);
+		replica->copies[node] = NULL;
+	}
+	replica->nodes = 0;
+	replica->owned = 0;
+}
@@ -0,0 +1,66 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include "stdint.h"
+#include <stdatomic.h>
+#include <stddef.h>
+
+#define PARALLEL_MAX_WORKERS 256
+#define PARALLEL_MAX_CPUS 1024
+#define PARALLEL_MAX_NODES 16
+#define PARALLEL_REPLICA_ALIGN 64
+
+// task(arg, index, thread) is called once for every index in [0,count), thread is in [0,threads)
+typedef void (*parallel_task)(void *arg, int64_t index, int thread);
+
+// progress and cancellation of a long running call, shared by all the threads working on it
+typedef struct parallel_control {
+	atomic_int cancelled;
+	atomic_int_fast64_t completed;
+	// a child is cancelled with its parent, cancelling the child leaves the parent alone. the progress of a child
+	// also counts for its parents
+	struct parallel_control *parent;
+	// cycles of work reported with parallel_charge, a control with a limit cancels itself once limit(limit_arg, cycles) != 0
+	atomic_uint_fast64_t cycles;
+	int (*limit)(const void *arg, uint64_t cycles);
+	const void *limit_arg;
+} parallel_control;
+
+// a copy of a read-only table on every NUMA node, with a single node the table itself is used
+typedef struct {
+	int nodes;
+	int owned;
+	void *copies[PARALLEL_MAX_NODES];
+} parallel_replica;
+
+// parallel_for runs on a pool of long-lived workers that is started on first use and grows to the largest thread count asked for
+// the calling thread is thread 0, the indices are split in contiguous blocks and idle threads steal half of the largest remaining block
+void parallel_for(int threads, int64_t count, parallel_task task, void *arg);
+void parallel_for_control(int threads, int64_t count, parallel_task task, void *arg, parallel_control *control);
+
+void parallel_control_init(parallel_control *control);
+// a private control for a part of the work of parent, which may be NULL
+void parallel_control_init_child(parallel_control *control, parallel_control *parent);
+void parallel_cancel(parallel_control *control);
+// also checks the parents and the limit, long tasks call it between small steps to stop early
+int parallel_cancelled(parallel_control *control);
+void parallel_charge(parallel_control *control, uint64_t cycles);
+
+// starts (at least) workers workers, with pin set every worker is pinned to one cpu, filling up a NUMA node before the next one
+// pinning only takes effect if it is set before the first worker starts, returns the number of workers
+int parallel_pool_start(int workers, int pin);
+// waits for the running jobs and stops the workers
+void parallel_pool_stop(void);
+
+int parallel_nodes(void);
+int parallel_current_node(void);
+// calls fn(arg, node) for every node on a thread that runs on that node, one node after the other. stops at the
+// first call that does not return 0 and returns -1, e.g. to initialize per-node tables in memory of their node
+int parallel_on_nodes(int (*fn)(void *arg, int node), void *arg);
+
+int parallel_replicate(parallel_replica *replica, const void *src, size_t size);
+// the copy on the node of the calling thread
+const void *parallel_local(const parallel_replica *replica);
+void parallel_replica_free(parallel_replica *replica);
+
+#endif
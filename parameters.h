@@ -8,14 +8,52 @@
 #define LOG(n)   (((n) >= 1<<16) ? (16 + LOG_8((n)>>16)) : LOG_8(n))
 
 #include "libkeccak.a.headers/SimpleFIPS202.h"
+#include "libkeccak.a.headers/KeccakHash.h"
 #include <openssl/rand.h>
 
 #define SEED_BYTES 16
 #define HASH_BYTES 32
+#define SHAKE128_RATE 168
 
-#define HASH(data,len,out) SHAKE128(out, HASH_BYTES, data, len);
-#define TREEHASH(data,len,out) SHAKE128(out, SEED_BYTES, data, len);
-#define EXPAND(data,len,out,outlen) SHAKE128(out, outlen, data, len);
+// the hash suite is part of the signature format, signatures only verify with the suite they were made with
+#define HASH_SUITE_SHAKE128 0
+#define HASH_SUITE_TURBOSHAKE128 1
+
+#ifndef HASH_SUITE
+	#define HASH_SUITE HASH_SUITE_SHAKE128
+#endif
+
+// TurboSHAKE128 is SHAKE128 with 12 instead of 24 rounds of Keccak-p, the domain byte 0x1F gives the same padding as SHAKE128
+#define HASH_DOMAIN 0x1F
+#define TURBOSHAKE128(out,outlen,data,len,domain) KeccakWidth1600_12rounds_Sponge(SHAKE128_RATE*8, 1600-SHAKE128_RATE*8, data, len, domain, out, outlen);
+
+#if HASH_SUITE == HASH_SUITE_TURBOSHAKE128
+	#define HASH(data,len,out) TURBOSHAKE128(out, HASH_BYTES, data, len, HASH_DOMAIN)
+	#define TREEHASH(data,len,out) TURBOSHAKE128(out, SEED_BYTES, data, len, HASH_DOMAIN)
+	#define EXPAND(data,len,out,outlen) TURBOSHAKE128(out, outlen, data, len, HASH_DOMAIN)
+
+	#define HASH_CTX KeccakWidth1600_12rounds_SpongeInstance
+	#define HASH_INIT(ctx) KeccakWidth1600_12rounds_SpongeInitialize(ctx, SHAKE128_RATE*8, 1600-SHAKE128_RATE*8);
+	#define HASH_UPDATE(ctx,data,len) KeccakWidth1600_12rounds_SpongeAbsorb(ctx, data, len);
+	#define HASH_FINAL(ctx,out) KeccakWidth1600_12rounds_SpongeAbsorbLastFewBits(ctx, HASH_DOMAIN); KeccakWidth1600_12rounds_SpongeSqueeze(ctx, out, HASH_BYTES);
+
+	#define EXPAND_INIT(ctx,data,len) HASH_INIT(ctx) HASH_UPDATE(ctx,data,len) KeccakWidth1600_12rounds_SpongeAbsorbLastFewBits(ctx, HASH_DOMAIN);
+	#define EXPAND_SQUEEZE(ctx,out,outlen) KeccakWidth1600_12rounds_SpongeSqueeze(ctx, out, outlen);
+#else
+	#define HASH(data,len,out) SHAKE128(out, HASH_BYTES, data, len);
+	#define TREEHASH(data,len,out) SHAKE128(out, SEED_BYTES, data, len);
+	#define EXPAND(data,len,out,outlen) SHAKE128(out, outlen, data, len);
+
+	// incremental version of HASH, for data that is not contiguous in memory
+	#define HASH_CTX Keccak_HashInstance
+	#define HASH_INIT(ctx) Keccak_HashInitialize_SHAKE128(ctx);
+	#define HASH_UPDATE(ctx,data,len) Keccak_HashUpdate(ctx, data, ((BitLength) (len))*8);
+	#define HASH_FINAL(ctx,out) Keccak_HashFinal(ctx, NULL); Keccak_HashSqueeze(ctx, out, HASH_BYTES*8);
+
+	// incremental version of EXPAND, the output is squeezed in pieces of any length
+	#define EXPAND_INIT(ctx,data,len) HASH_INIT(ctx) HASH_UPDATE(ctx,data,len) Keccak_HashFinal(ctx, NULL);
+	#define EXPAND_SQUEEZE(ctx,out,outlen) Keccak_HashSqueeze(ctx, out, ((BitLength) (outlen))*8);
+#endif
 
 #include <string.h>
 
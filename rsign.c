@@ -1,5 +1,9 @@
+#define _POSIX_C_SOURCE 200809L
 #include "rsign.h"
 #include "seedtree.h"
+#include "parallel.h"
+#include <stdatomic.h>
+#include <time.h>
 
 
 static inline
@@ -28,11 +32,72 @@ void keygen(unsigned char *pk, unsigned char *sk){
 	clear_grpelt(s);
 }
 
+void message_hash_init(message_hash_ctx *ctx){
+	HASH_INIT(&ctx->state);
+}
+
+void message_hash_update(message_hash_ctx *ctx, const unsigned char *m, uint64_t mlen){
+	HASH_UPDATE(&ctx->state, m, mlen);
+}
+
+// gives the same digest as HASH over the concatenation of all the updates
+void message_hash_final(message_hash_ctx *ctx, unsigned char *message_hash){
+	HASH_FINAL(&ctx->state, message_hash);
+}
+
+int ring_ctx_view(ring_ctx *ring, const unsigned char *pks, const int64_t rings){
+	memset(ring, 0, sizeof(ring_ctx));
+
+	if (rings < 1 || rings > (((int64_t) 1) << 32))
+		return -1;
+
+	ring->rings = rings;
+	ring->logN = log_round_up(rings);
+	ring->leaves = RING_TREE_LEAVES(rings);
+	ring->nodes = RING_TREE_NODES(rings);
+	ring->streaming = ring_streaming(rings);
+	ring->counter = COUNTER_RANDOMNESS;
+	ring->buf_len = EXECUTION_BUF_LEN(rings);
+	ring->commitments_len = EXECUTION_COMMITMENTS_LEN(rings);
+	ring->pks = pks;
+	return 0;
+}
+
+int ring_ctx_init(ring_ctx *ring, const unsigned char *pks, const int64_t rings){
+	if (ring_ctx_view(ring, NULL, rings) != 0)
+		return -1;
+
+	ring->allocated = malloc(rings*PK_BYTES + WORKSPACE_ALIGN);
+	if (ring->allocated == NULL){
+		ring_ctx_clear(ring);
+		return -1;
+	}
+	unsigned char *aligned = workspace_align(ring->allocated);
+	memcpy(aligned, pks, rings*PK_BYTES);
+	ring->pks = aligned;
+
+	// reject the ring if one of the members is not a valid public key
+	for (int64_t j = 0; j < rings; ++j)
+	{
+		if (!is_valid_pk((const public_key *) (ring->pks + j*PK_BYTES))){
+			ring_ctx_clear(ring);
+			return -1;
+		}
+	}
+
+	HASH(ring->pks, rings*PK_BYTES, ring->digest);
+	return 0;
+}
+
+void ring_ctx_clear(ring_ctx *ring){
+	free(ring->allocated);
+	memset(ring, 0, sizeof(ring_ctx));
+}
+
+// the hashed input of a commitment is R followed by the randomness, the salt is not part of it
 #ifdef BG
-void commit(const XELT *R, const unsigned char *randomness, const unsigned char *salt, unsigned char *commitment){
-	unsigned char buf[512 + 3*SEED_BYTES];
+static void commit_input(const XELT *R, const unsigned char *randomness, unsigned char *buf){
 	memcpy(buf+512,randomness,SEED_BYTES);
-	memcpy(buf+512+SEED_BYTES,salt,2*SEED_BYTES);
 
 	for (int i = 0; i < K; ++i)
 	{
@@ -41,33 +106,62 @@ void commit(const XELT *R, const unsigned char *randomness, const unsigned char
 			buf[i*128 + j] = (*R).high.vec[i].coeffs[j] || ((*R).high.vec[i].coeffs[j] << 4);
 		}
 	}
-
-	HASH(buf, 512 + SEED_BYTES, commitment);
 }
 #else
-void commit(const XELT *R, const unsigned char *randomness, const unsigned char *salt, unsigned char *commitment){
-	unsigned char buf[sizeof(XELT) + 3*SEED_BYTES];
+static void commit_input(const XELT *R, const unsigned char *randomness, unsigned char *buf){
 	memcpy(buf,(const unsigned char *)R,sizeof(XELT));
 	memcpy(buf+sizeof(XELT),randomness,SEED_BYTES);
-	memcpy(buf+sizeof(XELT)+SEED_BYTES,salt,2*SEED_BYTES);
-	HASH(buf, sizeof(XELT) + SEED_BYTES, commitment);
 }
 #endif
 
-void build_tree_and_path(const unsigned char *commitments_in, int logN, int64_t I, unsigned char * root, unsigned char *path){
-	uint64_t rings_round_up = ((uint64_t)1)<<logN;
-	unsigned char commitments[rings_round_up*HASH_BYTES];
-	memcpy(commitments,commitments_in,rings_round_up*HASH_BYTES);
+void commit(const XELT *R, const unsigned char *randomness, const unsigned char *salt, unsigned char *commitment){
+	unsigned char buf[COMMIT_INPUT_BYTES];
+	commit_input(R, randomness, buf);
+	HASH(buf, COMMIT_INPUT_BYTES, commitment);
+}
+
+void commit_batch(const XELT *R, const unsigned char *const *randomness, const unsigned char *salt, unsigned char *const *commitments, int count){
+	unsigned char buf[COMMIT_LANES][COMMIT_INPUT_BYTES];
+	const unsigned char *in[COMMIT_LANES];
+
+	for (int k = 0; k < count; k += COMMIT_LANES)
+	{
+		int lanes = (count - k < COMMIT_LANES) ? count - k : COMMIT_LANES;
+		if (lanes == 1){
+			commit(&R[k], randomness[k], salt, commitments[k]);
+			break;
+		}
+
+		for (int lane = 0; lane < lanes; ++lane)
+		{
+			commit_input(&R[k + lane], randomness[k + lane], buf[lane]);
+			in[lane] = buf[lane];
+		}
+		hash_lanes(in, COMMIT_INPUT_BYTES, commitments + k, lanes);
+	}
+}
+
+// the tree is built in place, so the commitments are overwritten. a level with an odd number of nodes
+// is completed with a single dummy node, the one of the l-th level is read from commitments + (leaves + l)*HASH_BYTES
+void build_unbalanced_tree_and_path(unsigned char *commitments, int64_t leaves, int64_t I, unsigned char * root, unsigned char *path){
+	int logN = log_round_up(leaves);
 	int64_t *intpath = (int64_t *) path;
 	unsigned char temp[HASH_BYTES];
+	int64_t nodes = leaves;
 
 	if(I >= 0){
 		memset(path,0,logN*HASH_BYTES);
 	}
 	for (int depth = logN-1; depth >= 0; --depth)
 	{
+		// the nodes of a level only ever overwrite indices below leaves, so the dummy nodes are still there
+		if (nodes % 2 == 1){
+			memmove(commitments + nodes*HASH_BYTES, commitments + (leaves + logN-1-depth)*HASH_BYTES, HASH_BYTES);
+			nodes++;
+		}
+
 		if (I >= 0){
-			for (int64_t i = 0; i < ((uint64_t) 1) << (depth+1); ++i)
+			for (int64_t i = 0; i < nodes; ++i)
 			{
 				int64_t mask = ((I^1) - i) | (i- (I^1));
 				mask >>=63;
@@ -84,19 +178,42 @@ void build_tree_and_path(const unsigned char *commitments_in, int logN, int64_t
 			I /= 2;
 		}
 
-		for (int i = 0; i < ((uint64_t) 1) << depth; ++i)
+		// levels with at least HASH_LANES_NARROW nodes are hashed up to COMMIT_LANES nodes at a time,
+		// a group reads its children before it overwrites nodes, and later groups only read nodes after it
+		nodes /= 2;
+		int lanes = (nodes >= HASH_LANES_NARROW) ? COMMIT_LANES : 1;
+		for (int64_t i = 0; i < nodes; i += lanes)
 		{
-			if(memcmp(commitments + HASH_BYTES*i*2,commitments + (2*i+1)*HASH_BYTES, HASH_BYTES ) > 0){
-				memcpy(temp, commitments + HASH_BYTES*i*2, HASH_BYTES);
-				memcpy(commitments + HASH_BYTES*i*2, commitments + HASH_BYTES*(i*2+1), HASH_BYTES);
-				memcpy(commitments + HASH_BYTES*(i*2+1), temp, HASH_BYTES);
+			int group = (nodes - i < lanes) ? nodes - i : lanes;
+			const unsigned char *in[COMMIT_LANES];
+			unsigned char *out[COMMIT_LANES];
+			for (int lane = 0; lane < group; ++lane)
+			{
+				unsigned char *left = commitments + HASH_BYTES*(i + lane)*2;
+				if(memcmp(left, left + HASH_BYTES, HASH_BYTES ) > 0){
+					memcpy(temp, left, HASH_BYTES);
+					memcpy(left, left + HASH_BYTES, HASH_BYTES);
+					memcpy(left + HASH_BYTES, temp, HASH_BYTES);
+				}
+				in[lane] = left;
+				out[lane] = commitments + (i + lane)*HASH_BYTES;
+			}
+
+			if (group == 1){
+				HASH(in[0],2*HASH_BYTES, out[0]);
+			}
+			else{
+				hash_lanes(in, 2*HASH_BYTES, out, group);
 			}
-			HASH(commitments + 2*i*HASH_BYTES,2*HASH_BYTES, commitments + i*HASH_BYTES);
 		}
 	}
 	memcpy(root,commitments,HASH_BYTES);
 }
 
+void build_tree_and_path(unsigned char *commitments, int logN, int64_t I, unsigned char * root, unsigned char *path){
+	build_unbalanced_tree_and_path(commitments, ((int64_t) 1) << logN, I, root, path);
+}
+
 void reconstruct_root(const unsigned char *data, const unsigned char *path, int logN, unsigned char *root){
 	unsigned char current[2*HASH_BYTES];
 	unsigned char temp[HASH_BYTES];
@@ -114,8 +231,6 @@ void reconstruct_root(const unsigned char *data, const unsigned char *path, int
 	memcpy(root,current,HASH_BYTES);
 }
 
-#define SHAKE128_RATE 168
-
 void derive_challenge(const unsigned char *challenge_seed, unsigned char *challenge){
 	memset(challenge,1,EXECUTIONS);
 	int zeros = 0;
@@ -176,241 +291,1704 @@ int log_round_up(int64_t a){
 	return logN;
 }
 
-int rsign(const unsigned char *sk, const int64_t I, const unsigned char *pks, const int64_t rings, const unsigned char *m, uint64_t mlen, unsigned char *sig, uint64_t *sig_len){
-	if (I >= rings || rings > (((uint64_t) 1) << 32))
-		return -1;
+static void execution_seedbuf(const unsigned char *seed, int i, const unsigned char *salt, unsigned char *seedbuf){
+	memcpy(seedbuf + SEED_BYTES, salt, HASH_BYTES);
+	uint32_t *ctr = (uint32_t *) (seedbuf + HASH_BYTES + SEED_BYTES);
+
+	memcpy(seedbuf, seed, SEED_BYTES);
+	(*ctr)  = EXECUTIONS + i; 
+}
 
-	int logN = log_round_up(rings);
-	uint64_t rings_round_up = (((uint64_t)1) << logN);
+// the commitment randomness of member j is the hash of the seed buffer of its execution and j,
+// the seed of r and the dummy seed are derived in the same way as members rings and rings+1
+static void derive_randomness(const unsigned char *const *seedbufs, const int64_t *members, int count, unsigned char *out){
+	unsigned char in[HASH_LANES][SEED_BUF_BYTES + sizeof(int64_t)];
+	unsigned char hashes[HASH_LANES][HASH_BYTES];
+	const unsigned char *in_lanes[HASH_LANES];
+	unsigned char *out_lanes[HASH_LANES];
 
-	GRPELTS2 *r = aligned_alloc(32, sizeof(GRPELTS2)*EXECUTIONS);
-	for (int i = 0; i < EXECUTIONS; ++i)
+	for (int lane = 0; lane < count; ++lane)
 	{
-		init_grpelt(r[i]);
+		memcpy(in[lane], seedbufs[lane], SEED_BUF_BYTES);
+		memcpy(in[lane] + SEED_BUF_BYTES, &members[lane], sizeof(int64_t));
+		in_lanes[lane] = in[lane];
+		out_lanes[lane] = hashes[lane];
 	}
+	hash_lanes(in_lanes, sizeof(in[0]), out_lanes, count);
 
-	unsigned char *seed_tree = malloc((2*EXECUTIONS-1)*SEED_BYTES);
-	unsigned char *seeds = seed_tree + (EXECUTIONS-1)*SEED_BYTES;
-
-	#define BUF_LEN (SEED_BYTES*(rings+2))
-	unsigned char seedbuf[SEED_BUF_BYTES];
-	unsigned char buf[BUF_LEN];
-	unsigned char commitments[HASH_BYTES*rings_round_up];
-	unsigned char *commitment_randomness = malloc(EXECUTIONS*SEED_BYTES);
-	XELT R;
-	unsigned char *roots = malloc(HASH_BYTES*(EXECUTIONS+2));
-	unsigned char *paths = malloc(HASH_BYTES*EXECUTIONS*logN);
-
-	// generate response
-	GRPELTS2 z;
-	GRPELTS1 s;
-	init_grpelt(z);
-	init_grpelt(s);
-	sample_S1(s,sk);
-
-	// choose salt
-	RAND_bytes(RSIG_SALT(sig),HASH_BYTES);
+	for (int lane = 0; lane < count; ++lane)
+	{
+		memcpy(out + lane*SEED_BYTES, hashes[lane], SEED_BYTES);
+	}
+}
 
-	// copy salt
-	memcpy(roots + (EXECUTIONS+1)*HASH_BYTES, RSIG_SALT(sig), HASH_BYTES);
-	memcpy(seedbuf + SEED_BYTES, RSIG_SALT(sig), HASH_BYTES);
-	uint32_t *ctr = (uint32_t *) (seedbuf + HASH_BYTES + SEED_BYTES);
+// the randomness of members first, ..., first+count-1 of one execution
+static void derive_member_randomness(const unsigned char *seedbuf, int64_t first, int count, unsigned char *out){
+	const unsigned char *seedbufs[HASH_LANES];
+	int64_t members[HASH_LANES];
+	for (int k = 0; k < count; k += HASH_LANES)
+	{
+		int lanes = (count - k < HASH_LANES) ? count - k : HASH_LANES;
+		for (int lane = 0; lane < lanes; ++lane)
+		{
+			seedbufs[lane] = seedbuf;
+			members[lane] = first + k + lane;
+		}
+		derive_randomness(seedbufs, members, lanes, out + k*SEED_BYTES);
+	}
+}
 
-	// pick random seeds
-	restart: generate_seed_tree(seed_tree,EXECUTIONS,RSIG_SALT(sig));
+// the dummy nodes first, ..., first+count-1 are the hashes of the dummy seed and their index,
+// in a padded tree those are the dummy leaves, in an unpadded tree the dummy node of every level
+static void derive_dummies(const unsigned char *dummy_seed, int64_t first, int count, unsigned char *out){
+	unsigned char in[HASH_LANES][SEED_BYTES + sizeof(int64_t)];
+	const unsigned char *in_lanes[HASH_LANES];
+	unsigned char *out_lanes[HASH_LANES];
+	for (int k = 0; k < count; k += HASH_LANES)
+	{
+		int lanes = (count - k < HASH_LANES) ? count - k : HASH_LANES;
+		for (int lane = 0; lane < lanes; ++lane)
+		{
+			int64_t index = first + k + lane;
+			memcpy(in[lane], dummy_seed, SEED_BYTES);
+			memcpy(in[lane] + SEED_BYTES, &index, sizeof(int64_t));
+			in_lanes[lane] = in[lane];
+			out_lanes[lane] = out + (k + lane)*HASH_BYTES;
+		}
+		hash_lanes(in_lanes, sizeof(in[0]), out_lanes, lanes);
+	}
+}
 
-	// hash message
-	HASH(m,mlen,roots + EXECUTIONS*HASH_BYTES);
+// the dummy nodes of the tree of an execution, stored after the rings commitments
+static void commit_dummies(const ring_ctx *ring, const unsigned char *dummy_seed, unsigned char *commitments){
+	if (ring->counter)
+		derive_dummies(dummy_seed, 0, ring->nodes - ring->rings, commitments + ring->rings*HASH_BYTES);
+	else
+		EXPAND(dummy_seed, SEED_BYTES, commitments + ring->rings*HASH_BYTES, (ring->nodes - ring->rings)*HASH_BYTES);
+}
 
-	for (int i = 0; i < EXECUTIONS; ++i)
+typedef struct {
+	const ring_ctx *ring;
+	const PREP_GRPELT *pg;
+	const unsigned char *buf;
+	const unsigned char *seedbuf;
+	const unsigned char *salt;
+	unsigned char *commitments;
+	parallel_control *control;
+} commit_members_job;
+
+static void commit_members(void *arg, int64_t chunk, int thread){
+	commit_members_job *job = (commit_members_job *) arg;
+	int64_t end = (chunk+1)*MEMBER_CHUNK;
+	if (end > job->ring->rings)
+		end = job->ring->rings;
+
+	XELT R[COMMIT_LANES];
+	const unsigned char *randomness[COMMIT_LANES];
+	unsigned char *commitments[COMMIT_LANES];
+	for (int64_t j = chunk*MEMBER_CHUNK; j < end; j += COMMIT_LANES)
 	{
-		// generate commitment randomness and r
-		memcpy(seedbuf, seeds + i*SEED_BYTES, SEED_BYTES);
-		(*ctr)  = EXECUTIONS + i; 
-		EXPAND(seedbuf, SEED_BUF_BYTES, buf, BUF_LEN);
+		// a large ring is stopped between the members, not only between the executions
+		if (parallel_cancelled(job->control))
+			return;
+		uint64_t start = cpu_cycles();
+
+		int lanes = (end - j < COMMIT_LANES) ? end - j : COMMIT_LANES;
+		unsigned char derived[COMMIT_LANES*SEED_BYTES];
+		if (job->ring->counter)
+			derive_member_randomness(job->seedbuf, j, lanes, derived);
+		finish_action_multi(R, (const public_key*) (job->ring->pks + j*sizeof(public_key)), lanes, job->pg);
+		for (int lane = 0; lane < lanes; ++lane)
+		{
+			if (job->ring->counter)
+				randomness[lane] = derived + lane*SEED_BYTES;
+			else
+				randomness[lane] = job->buf + (j + lane)*SEED_BYTES;
+			commitments[lane] = job->commitments + (j + lane)*HASH_BYTES;
+		}
+		commit_batch(R, randomness, job->salt, commitments, lanes);
+		parallel_charge(job->control, cpu_cycles() - start);
+	}
+}
 
-		// sample r
-		sample_S2_with_seed(buf + SEED_BYTES*rings, r[i]);
+int ring_member_threads(int64_t rings, int threads){
+	if (threads <= 1 || rings < MEMBER_CHUNK*threads)
+		return 1;
 
-		PREP_GRPELT pg;
-		do_half_action(&pg,r[i]);
+	// split the ring members if the per-thread buffers of an execution get large,
+	// or if there are too few executions per thread to keep all of them busy until the end
+	if (rings >= MEMBER_SPLIT_RING_SIZE || EXECUTIONS < MIN_EXECUTIONS_PER_THREAD*threads)
+		return threads;
 
-		// TODO: do this without accessing secret indices !!
-		memcpy(commitment_randomness + i*SEED_BYTES , buf + I*SEED_BYTES , SEED_BYTES);
+	return 1;
+}
 
-		// compute R_i and commitments
-		for (int j = 0; j < rings; ++j)
-		{
-			finish_action(&R,(public_key*) (pks + j*sizeof(public_key)), &pg);
-			commit(&R,buf + j*SEED_BYTES, RSIG_SALT(sig), commitments + j*HASH_BYTES);
-		}
+int execution_threads(int64_t rings, int threads, int *member_threads){
+	// split either the ring members or the executions over the threads
+	*member_threads = ring_member_threads(rings, threads);
+	threads /= *member_threads;
+	if (threads < 1)
+		threads = 1;
+	if (threads > EXECUTIONS)
+		threads = EXECUTIONS;
+	return threads;
+}
 
-		// generate dummy commitments
-		EXPAND(buf + SEED_BYTES * (rings +1), SEED_BYTES, commitments + rings*HASH_BYTES, (rings_round_up-rings)*HASH_BYTES);
+uint64_t workspace_take(uint64_t *size, uint64_t bytes){
+	uint64_t offset = *size;
+	(*size) += (bytes + WORKSPACE_ALIGN - 1) & ~((uint64_t) WORKSPACE_ALIGN - 1);
+	return offset;
+}
 
-		build_tree_and_path(commitments, logN, I, roots + i*HASH_BYTES, paths + i*HASH_BYTES*logN );
-	}
+unsigned char *workspace_align(unsigned char *workspace){
+	return (unsigned char *) (((uintptr_t) workspace + WORKSPACE_ALIGN - 1) & ~((uintptr_t) WORKSPACE_ALIGN - 1));
+}
 
-	// generate challenge
-	EXPAND(roots, HASH_BYTES*(EXECUTIONS+2), RSIG_CHALLENGE(sig), SEED_BYTES);
-	unsigned char *challenge = malloc(EXECUTIONS);
-	derive_challenge(RSIG_CHALLENGE(sig),challenge);
+uint64_t monotonic_ns(void){
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t) now.tv_sec*1000000000 + now.tv_nsec;
+}
 
-	int zeros = 0;
-	int ones = 0;
-	for (int i = 0; i < EXECUTIONS; ++i)
-	{
-		if (challenge[i] == 0)
-		{
-			// compute and pack z in signature
-			add(z, s, r[i]);
-			if( !is_in_S3(z) ){
-				restarts += 1;
-				goto restart;
-			}
+uint64_t cpu_cycles(void){
+	return rdtsc();
+}
 
-			#ifdef BG
-			XELT W;
-			do_action(&W,&X0,z);
-			if( !bg_check(&W) ){
-				restarts += 1;
-				goto restart;
-			}
-			#endif
+int verify_budget_exceeded(const verify_budget *budget, uint64_t cycles){
+	if (budget == NULL)
+		return 0;
+	if (budget->cycles != 0 && cycles >= budget->cycles)
+		return 1;
+	if (budget->deadline_ns != 0 && monotonic_ns() >= budget->deadline_ns)
+		return 1;
+	return 0;
+}
 
-			pack_S3(RSIG_Z(sig) + zeros*S3_BYTES, z);
+// the limit of the control of a budget
+static int verify_budget_limit(const void *budget, uint64_t cycles){
+	return verify_budget_exceeded((const verify_budget *) budget, cycles);
+}
 
-			// copy commitment randomess to signature
-			memcpy(RSIG_COMMITMENT_RANDOMNESS(sig) + zeros*SEED_BYTES, commitment_randomness + i*SEED_BYTES, SEED_BYTES);
-			// copy Merkle tree path to signature
-			memcpy(RSIG_PATHS(sig) + zeros*logN*HASH_BYTES, paths + i*HASH_BYTES*logN, HASH_BYTES*logN);
-			zeros++;
-		}
+// expands the seed of the i-th execution into the commitment randomness, the seed of r and the dummy seed
+static void expand_execution(const unsigned char *seed, int i, const ring_ctx *ring, const unsigned char *salt, unsigned char *buf){
+	unsigned char seedbuf[SEED_BUF_BYTES];
+	execution_seedbuf(seed, i, salt, seedbuf);
+	EXPAND(seedbuf, SEED_BUF_BYTES, buf, ring->buf_len);
+}
+
+// an expansion that can be kept in an array, the sponge of TurboSHAKE is aligned to more than its size
+typedef struct {
+	HASH_CTX ctx;
+} expand_stream;
+
+// squeezes and drops the next bytes of an expansion
+static void expand_skip(HASH_CTX *ctx, uint64_t bytes){
+	unsigned char scratch[SHAKE128_RATE*8];
+	while (bytes > 0){
+		uint64_t len = (bytes < sizeof(scratch)) ? bytes : sizeof(scratch);
+		EXPAND_SQUEEZE(ctx, scratch, len);
+		bytes -= len;
 	}
+}
 
-	release_seeds(seed_tree, EXECUTIONS, challenge, RSIG_SEEDS(sig,logN) , sig_len );
-	(*sig_len) *= SEED_BYTES;
-	(*sig_len) += RSIG_SEEDS(0,logN);
+int ring_streaming(int64_t rings){
+	return rings >= STREAMING_RING_SIZE;
+}
 
-	for (int i = 0; i < EXECUTIONS; ++i)
+// out ^= in if a == b, without branching on a or b
+static void select_if_equal(unsigned char *out, const unsigned char *in, int len, int64_t a, int64_t b){
+	int64_t mask = (a - b) | (b - a);
+	mask >>= 63;
+	mask ^= 0xffffffffffffffff;
+	for (int k = 0; k < len; ++k)
 	{
-		clear_grpelt(r[i]);
+		out[k] ^= (unsigned char) mask & in[k];
 	}
+}
 
-	free(r);
-	free(seed_tree);
-	free(commitment_randomness);
-	free(roots);
-	free(paths);
-	free(challenge);
+typedef struct {
+	const unsigned char *seed;
+	int i;
+	const ring_ctx *ring;
+	int64_t I;
+	const unsigned char *salt;
+	const PREP_GRPELT *pg;
+	const unsigned char *dummy_seed;
+	const unsigned char *dummies;
+	// without counter randomness, the expansions of the execution seed and the dummy seed where subtree s starts
+	const expand_stream *randomness_streams;
+	const expand_stream *dummy_streams;
+	int subtree_logN;
+	unsigned char *subtree_roots;
+	unsigned char *subtree_paths;
+	unsigned char *subtree_randomness;
+	parallel_control *control;
+} treehash_job;
+
+// adds the j-th node of a level to the stack of a treehash, the nodes on the path of I are captured below the subtree root
+static void treehash_push(const treehash_job *job, unsigned char *stack, int *heights, int *top, const unsigned char *in, int height, int64_t j, unsigned char *path){
+	unsigned char pair[2*HASH_BYTES];
+	unsigned char node[HASH_BYTES];
+	unsigned char temp[HASH_BYTES];
 
-	clear_grpelt(z);
-	clear_grpelt(s);
+	memcpy(node, in, HASH_BYTES);
+	while (1){
+		if (job->I >= 0 && height < job->subtree_logN)
+			select_if_equal(path + (job->ring->logN-1-height)*HASH_BYTES, node, HASH_BYTES, j, (job->I >> height)^1);
+
+		if (*top == 0 || heights[*top-1] != height)
+			break;
+
+		// the node on the stack is the left sibling, the pair is sorted as in build_tree_and_path
+		memcpy(pair, stack + (*top-1)*HASH_BYTES, HASH_BYTES);
+		memcpy(pair + HASH_BYTES, node, HASH_BYTES);
+		if(memcmp(pair, pair + HASH_BYTES, HASH_BYTES ) > 0){
+			memcpy(temp, pair, HASH_BYTES);
+			memcpy(pair, pair + HASH_BYTES, HASH_BYTES);
+			memcpy(pair + HASH_BYTES, temp, HASH_BYTES);
+		}
+		HASH(pair, 2*HASH_BYTES, node);
+
+		(*top)--;
+		height++;
+		j >>= 1;
+	}
+
+	memcpy(stack + (*top)*HASH_BYTES, node, HASH_BYTES);
+	heights[*top] = height;
+	(*top)++;
 }
 
-int  rverify(const unsigned char *pks, const int64_t rings, const unsigned char *m, uint64_t mlen, const unsigned char *sig){
-	if (rings > (((uint64_t) 1) << 32))
-		return -1;
+// streams the leaves of subtree s, the commitment randomness and the dummy commitments are derived from their index
+// or squeezed from where the expansions are at the start of the subtree
+static void treehash_subtree(void *arg, int64_t s, int thread){
+	treehash_job *job = (treehash_job *) arg;
+	int64_t rings = job->ring->rings;
+	int64_t first = s << job->subtree_logN;
+	int64_t end = (s+1) << job->subtree_logN;
+	if (end > job->ring->leaves)
+		end = job->ring->leaves;
+	int64_t real_end = (end < rings) ? end : rings;
+	unsigned char *path = job->subtree_paths + s*job->ring->logN*HASH_BYTES;
+	unsigned char *commitment_randomness = job->subtree_randomness + s*SEED_BYTES;
+
+	unsigned char stack[(job->subtree_logN+1)*HASH_BYTES];
+	int heights[job->subtree_logN+1];
+	int top = 0;
 
-	int valid = 0;
+	unsigned char seedbuf[SEED_BUF_BYTES];
+	execution_seedbuf(job->seed, job->i, job->salt, seedbuf);
 
-	int logN = log_round_up(rings);
-	uint64_t rings_round_up = (((uint64_t)1) << logN);
+	expand_stream randomness_stream, dummy_stream;
+	if (!job->ring->counter){
+		randomness_stream = job->randomness_streams[s];
+		dummy_stream = job->dummy_streams[s];
+	}
 
-	// expand challenge
-	unsigned char challenge[EXECUTIONS];
-	derive_challenge(RSIG_CHALLENGE(sig),challenge);
+	XELT R[COMMIT_LANES];
+	unsigned char randomness[COMMIT_LANES*SEED_BYTES];
+	unsigned char leaves[COMMIT_LANES*HASH_BYTES];
+	const unsigned char *randomness_lanes[COMMIT_LANES];
+	unsigned char *leaf_lanes[COMMIT_LANES];
+	int lanes;
+	for (int64_t j = first; j < end; j += lanes)
+	{
+		if (parallel_cancelled(job->control))
+			return;
+		uint64_t start = cpu_cycles();
+
+		if (j < rings){
+			lanes = (real_end - j < COMMIT_LANES) ? real_end - j : COMMIT_LANES;
+			if (job->ring->counter){
+				derive_member_randomness(seedbuf, j, lanes, randomness);
+			}
+			else{
+				EXPAND_SQUEEZE(&randomness_stream.ctx, randomness, lanes*SEED_BYTES);
+			}
+			finish_action_multi(R, (const public_key*) (job->ring->pks + j*sizeof(public_key)), lanes, job->pg);
+			for (int lane = 0; lane < lanes; ++lane)
+			{
+				randomness_lanes[lane] = randomness + lane*SEED_BYTES;
+				leaf_lanes[lane] = leaves + lane*HASH_BYTES;
+				if (job->I >= 0)
+					select_if_equal(commitment_randomness, randomness + lane*SEED_BYTES, SEED_BYTES, j + lane, job->I);
+			}
+			commit_batch(R, randomness_lanes, job->salt, leaf_lanes, lanes);
+		}
+		else{
+			// generate dummy commitments
+			lanes = (end - j < COMMIT_LANES) ? end - j : COMMIT_LANES;
+			if (job->ring->counter){
+				derive_dummies(job->dummy_seed, j - rings, lanes, leaves);
+			}
+			else{
+				EXPAND_SQUEEZE(&dummy_stream.ctx, leaves, lanes*HASH_BYTES);
+			}
+		}
 
-	// derive seeds
-	unsigned char seed_tree[(2*EXECUTIONS-1)*SEED_BYTES];
-	unsigned char *seeds = seed_tree + (EXECUTIONS-1)*SEED_BYTES;
-	uint64_t nodes_used;
-	fill_down(seed_tree,EXECUTIONS, challenge, RSIG_SEEDS(sig,logN), &nodes_used, RSIG_SALT(sig));
+		for (int lane = 0; lane < lanes; ++lane)
+		{
+			treehash_push(job, stack, heights, &top, leaves + lane*HASH_BYTES, 0, j + lane, path);
+		}
+		parallel_charge(job->control, cpu_cycles() - start);
+	}
 
-	// reconstruct roots
-	unsigned char roots[(EXECUTIONS+2)*HASH_BYTES];
+	// the last subtree of an unpadded tree is completed with the dummy node of every level that has an odd number of nodes,
+	// the node on top of the stack is the last one of its level
+	while (top > 1 || heights[0] < job->subtree_logN){
+		int height = heights[top-1];
+		treehash_push(job, stack, heights, &top, job->dummies + height*HASH_BYTES, height, ((end - 1) >> height) + 1, path);
+	}
 
-	// hash message
-	HASH(m,mlen,roots + EXECUTIONS*HASH_BYTES)
+	memcpy(job->subtree_roots + s*HASH_BYTES, stack, HASH_BYTES);
+}
 
-	// copy salt
-	memcpy(roots + (EXECUTIONS+1)*HASH_BYTES, RSIG_SALT(sig), HASH_BYTES);
+void commit_to_ring_streaming(const unsigned char *seed, int i, const ring_ctx *ring, const int64_t I, const unsigned char *salt, GRPELTS2 *r, unsigned char *commitment_randomness, unsigned char *root, unsigned char *path, int threads, parallel_control *control){
+	int64_t rings = ring->rings;
+	int logN = ring->logN;
+	uint64_t start = cpu_cycles();
 
-	int zeros = 0;
-	int ones = 0;
-	GRPELTS2 r,z;
-	XELT R;
-	init_grpelt(r);
-	init_grpelt(z);
+	// the tree is split in a power of two subtrees, one per thread, that are streamed independently
+	int subtrees_logN = 0;
+	while (subtrees_logN < logN && (2 << subtrees_logN) <= threads){
+		subtrees_logN++;
+	}
+	int subtree_logN = logN - subtrees_logN;
+	int64_t subtrees = (ring->leaves + (((int64_t) 1) << subtree_logN) - 1) >> subtree_logN;
 
-	unsigned char buf[BUF_LEN];
 	unsigned char seedbuf[SEED_BUF_BYTES];
-	memcpy(seedbuf + SEED_BYTES, RSIG_SALT(sig) , HASH_BYTES);
-	uint32_t *ctr = (uint32_t *) (seedbuf + SEED_BYTES + HASH_BYTES);
+	unsigned char seeds[2*SEED_BYTES];
+	execution_seedbuf(seed, i, salt, seedbuf);
+
+	// the expansions can not start in the middle, so they are squeezed once up to the seeds at the end of the execution
+	// expansion and up to the last dummy, keeping the sponge where every subtree starts
+	expand_stream randomness_streams[subtrees];
+	expand_stream dummy_streams[subtrees];
+	if (ring->counter){
+		// the seed of r and the dummy seed are derived as members rings and rings+1
+		derive_member_randomness(seedbuf, rings, 2, seeds);
+	}
+	else{
+		expand_stream stream;
+		int64_t position = 0;
+		EXPAND_INIT(&stream.ctx, seedbuf, SEED_BUF_BYTES);
+		for (int64_t s = 0; s < subtrees; ++s)
+		{
+			int64_t first = (s << subtree_logN < rings) ? s << subtree_logN : rings;
+			expand_skip(&stream.ctx, (first - position)*SEED_BYTES);
+			position = first;
+			randomness_streams[s] = stream;
+		}
+		expand_skip(&stream.ctx, (rings - position)*SEED_BYTES);
+		EXPAND_SQUEEZE(&stream.ctx, seeds, 2*SEED_BYTES);
 
-	unsigned char commitments[HASH_BYTES*rings_round_up];
-	for (int i = 0; i < EXECUTIONS; ++i)
+		position = 0;
+		EXPAND_INIT(&stream.ctx, seeds + SEED_BYTES, SEED_BYTES);
+		for (int64_t s = 0; s < subtrees; ++s)
+		{
+			int64_t first = (s << subtree_logN > rings) ? (s << subtree_logN) - rings : 0;
+			expand_skip(&stream.ctx, (first - position)*HASH_BYTES);
+			position = first;
+			dummy_streams[s] = stream;
+		}
+	}
+
+	// sample r
+	sample_S2_with_seed(seeds, r[0]);
+
+	PREP_GRPELT pg;
+	do_half_action(&pg,r[0]);
+
+	// the dummy nodes of an unpadded tree, the ones above the subtrees go after the subtree roots
+	unsigned char dummies[logN*HASH_BYTES];
+	if (ring->counter)
+		derive_dummies(seeds + SEED_BYTES, 0, logN, dummies);
+	else
+		EXPAND(seeds + SEED_BYTES, SEED_BYTES, dummies, logN*HASH_BYTES);
+
+	unsigned char subtree_roots[(subtrees + subtrees_logN)*HASH_BYTES];
+	memcpy(subtree_roots + subtrees*HASH_BYTES, dummies + subtree_logN*HASH_BYTES, subtrees_logN*HASH_BYTES);
+	unsigned char subtree_paths[subtrees*logN*HASH_BYTES];
+	unsigned char subtree_randomness[subtrees*SEED_BYTES];
+	memset(subtree_paths, 0, sizeof(subtree_paths));
+	memset(subtree_randomness, 0, sizeof(subtree_randomness));
+
+	// the subtrees charge their own cycles
+	parallel_charge(control, cpu_cycles() - start);
+	treehash_job job = {seed, i, ring, I, salt, &pg, seeds + SEED_BYTES, dummies, randomness_streams, dummy_streams, subtree_logN, subtree_roots, subtree_paths, subtree_randomness, control};
+	parallel_for(threads, subtrees, treehash_subtree, &job);
+
+	if (I < 0){
+		build_unbalanced_tree_and_path(subtree_roots, subtrees, -1, root, NULL);
+		return;
+	}
+
+	// the top of the path comes from the tree of subtree roots, the rest from the subtree that contains I
+	build_unbalanced_tree_and_path(subtree_roots, subtrees, I >> subtree_logN, root, path);
+	memset(path + subtrees_logN*HASH_BYTES, 0, (logN - subtrees_logN)*HASH_BYTES);
+	for (int64_t s = 0; s < subtrees; ++s)
 	{
-		if (challenge[i] == 0){
-			// unpack z
-			unpack_S3(RSIG_Z(sig) + zeros*S3_BYTES, z);
+		for (int k = subtrees_logN*HASH_BYTES; k < logN*HASH_BYTES; ++k)
+		{
+			path[k] ^= subtree_paths[s*logN*HASH_BYTES + k];
+		}
+	}
 
-			if(!is_in_S3(z)){
-				printf("z not in S3! \n");
-				valid = -1;
-				break;
+	if (commitment_randomness != NULL){
+		memset(commitment_randomness, 0, SEED_BYTES);
+		for (int64_t s = 0; s < subtrees; ++s)
+		{
+			for (int k = 0; k < SEED_BYTES; ++k)
+			{
+				commitment_randomness[k] ^= subtree_randomness[s*SEED_BYTES + k];
 			}
+		}
+	}
+}
 
-			// compute z*X_0
-			do_action(&R,&X0,z);
+void commit_to_ring(const unsigned char *seed, int i, const ring_ctx *ring, const int64_t I, const unsigned char *salt, GRPELTS2 *r, unsigned char *buf, unsigned char *commitments, unsigned char *commitment_randomness, unsigned char *root, unsigned char *path, int threads, parallel_control *control){
+	int64_t rings = ring->rings;
+	if (ring->streaming){
+		commit_to_ring_streaming(seed, i, ring, I, salt, r, commitment_randomness, root, path, threads, control);
+		return;
+	}
+	uint64_t start = cpu_cycles();
 
-			// commit to it
-			commit(&R,RSIG_COMMITMENT_RANDOMNESS(sig) + SEED_BYTES*zeros, RSIG_SALT(sig), commitments);
-			// reconstruct root
-			reconstruct_root(commitments, RSIG_PATHS(sig) + zeros*logN*HASH_BYTES, logN, roots + i*HASH_BYTES);
-			zeros++;
+	unsigned char seedbuf[SEED_BUF_BYTES];
+	unsigned char seeds[2*SEED_BYTES];
+	execution_seedbuf(seed, i, salt, seedbuf);
+
+	// generate commitment randomness and r
+	if (ring->counter){
+		derive_member_randomness(seedbuf, rings, 2, seeds);
+		if (commitment_randomness != NULL)
+			derive_member_randomness(seedbuf, I, 1, commitment_randomness);
+	}
+	else{
+		expand_execution(seed, i, ring, salt, buf);
+		memcpy(seeds, buf + SEED_BYTES*rings, 2*SEED_BYTES);
+
+		if (commitment_randomness != NULL){
+			// TODO: do this without accessing secret indices !!
+			memcpy(commitment_randomness, buf + I*SEED_BYTES , SEED_BYTES);
 		}
-		else{
-			// generate commitment randomness and r
-			memcpy(seedbuf, seeds + i*SEED_BYTES, SEED_BYTES);
-			(*ctr)  = EXECUTIONS + i; 
-			EXPAND(seedbuf, SEED_BUF_BYTES, buf, BUF_LEN);
+	}
+
+	// sample r
+	sample_S2_with_seed(seeds, r[0]);
+
+	PREP_GRPELT pg;
+	do_half_action(&pg,r[0]);
+
+	// compute R_i and commitments, the members charge their own cycles
+	parallel_charge(control, cpu_cycles() - start);
+	commit_members_job job = {ring, &pg, buf, seedbuf, salt, commitments, control};
+	parallel_for(threads, (rings + MEMBER_CHUNK - 1)/MEMBER_CHUNK, commit_members, &job);
+	start = cpu_cycles();
+
+	// generate dummy commitments
+	commit_dummies(ring, seeds + SEED_BYTES, commitments);
+
+	build_unbalanced_tree_and_path(commitments, ring->leaves, I, root, path);
+	parallel_charge(control, cpu_cycles() - start);
+}
 
-			// sample r
-			sample_S2_with_seed(buf + SEED_BYTES*rings, r);
+void commit_to_ring_tile(const ring_commitment *tile, int count, const ring_ctx *ring, GRPELTS2 *r, unsigned char *bufs, unsigned char *commitments){
+	int64_t rings = ring->rings;
+	PREP_GRPELT pg[VERIFY_TILE];
+	XELT R[COMMIT_LANES];
+	const unsigned char *randomness[COMMIT_LANES];
+	unsigned char *lane_commitments[COMMIT_LANES];
+	unsigned char seeds[VERIFY_TILE][2*SEED_BYTES];
+	unsigned char seedbufs[VERIFY_TILE][SEED_BUF_BYTES];
 
-			PREP_GRPELT pg;
-			do_half_action(&pg,r);
+	for (int t = 0; t < count; ++t)
+	{
+		if (ring->counter){
+			execution_seedbuf(tile[t].seed, tile[t].i, tile[t].salt, seedbufs[t]);
+			derive_member_randomness(seedbufs[t], rings, 2, seeds[t]);
+		}
+		else{
+			expand_execution(tile[t].seed, tile[t].i, ring, tile[t].salt, bufs + t*ring->buf_len);
+			memcpy(seeds[t], bufs + t*ring->buf_len + SEED_BYTES*rings, 2*SEED_BYTES);
+		}
+		sample_S2_with_seed(seeds[t], r[t]);
+		do_half_action(&pg[t],r[t]);
+	}
 
-			// compute R_i and commitments
-			for (int j = 0; j < rings; ++j)
+	// every public key is loaded once for the whole tile
+	for (int64_t j = 0; j < rings; ++j)
+	{
+		for (int t = 0; t < count; t += COMMIT_LANES)
+		{
+			int lanes = (count - t < COMMIT_LANES) ? count - t : COMMIT_LANES;
+			// the randomness of member j in lanes executions at once
+			unsigned char derived[COMMIT_LANES*SEED_BYTES];
+			if (ring->counter){
+				const unsigned char *lane_seedbufs[COMMIT_LANES];
+				int64_t members[COMMIT_LANES];
+				for (int lane = 0; lane < lanes; ++lane)
+				{
+					lane_seedbufs[lane] = seedbufs[t + lane];
+					members[lane] = j;
+				}
+				derive_randomness(lane_seedbufs, members, lanes, derived);
+			}
+			for (int lane = 0; lane < lanes; ++lane)
 			{
-				finish_action(&R, (public_key*) (pks + j*sizeof(public_key)), &pg);
-				commit(&R,buf + j*SEED_BYTES, RSIG_SALT(sig), commitments + j*HASH_BYTES);
+				finish_action(&R[lane],(const public_key*) (ring->pks + j*sizeof(public_key)), &pg[t + lane]);
+				if (ring->counter)
+					randomness[lane] = derived + lane*SEED_BYTES;
+				else
+					randomness[lane] = bufs + (t + lane)*ring->buf_len + j*SEED_BYTES;
+				lane_commitments[lane] = commitments + (t + lane)*HASH_BYTES*ring->nodes + j*HASH_BYTES;
 			}
+			// the salt is not hashed, so the executions of a tile can share a batch
+			commit_batch(R, randomness, tile[t].salt, lane_commitments, lanes);
+		}
+	}
 
-			// generate dummy commitments
-			EXPAND(buf + SEED_BYTES * (rings +1), SEED_BYTES, commitments + rings*HASH_BYTES, (rings_round_up-rings)*HASH_BYTES);
+	for (int t = 0; t < count; ++t)
+	{
+		unsigned char *tile_commitments = commitments + t*HASH_BYTES*ring->nodes;
 
-			// compute root
-			build_tree_and_path(commitments, logN, -1 , roots + i*HASH_BYTES, NULL );
-			ones++;
-		}
+		// generate dummy commitments
+		commit_dummies(ring, seeds[t] + SEED_BYTES, tile_commitments);
+
+		build_unbalanced_tree_and_path(tile_commitments, ring->leaves, -1, tile[t].root, NULL);
 	}
+}
 
-	clear_grpelt(r);
-	clear_grpelt(z);
+// the transcript hashed into the challenge: the roots of the executions, the message hash and the salt,
+// followed by the commitments to T' of the executions for linkable signatures
+#define TRANSCRIPT_ROOTS(t) (t)
+#define TRANSCRIPT_MESSAGE_HASH(t) (TRANSCRIPT_ROOTS(t) + HASH_BYTES*EXECUTIONS)
+#define TRANSCRIPT_SALT(t) (TRANSCRIPT_MESSAGE_HASH(t) + HASH_BYTES)
+#define TRANSCRIPT_TPRIME(t) (TRANSCRIPT_SALT(t) + HASH_BYTES)
+#define TRANSCRIPT_BYTES(linkable) (TRANSCRIPT_TPRIME(0) + ((linkable) ? HASH_BYTES*EXECUTIONS : 0))
 
-	// check hash of roots
-	unsigned char challenge_seed[SEED_BYTES];
-	EXPAND(roots, HASH_BYTES*(EXECUTIONS+2), challenge_seed, SEED_BYTES);
+// a linkable signature is the tag followed by a signature with the layout of RSIG_*
+#define SIG_TAG_BYTES(linkable) ((linkable) ? PK_BYTES : 0)
 
-	if(memcmp(RSIG_CHALLENGE(sig) , challenge_seed, SEED_BYTES) != 0){
-		printf("challenge seed does not match! \n");
-		return -1;
+// the signer has to be a member of the ring, an empty ring is a view of a ring whose size is out of range
+static int ring_member(const int64_t I, const ring_ctx *ring){
+	return I >= 0 && I < ring->rings;
+}
+
+typedef struct {
+	const unsigned char *seeds;
+	const ring_ctx *ring;
+	int64_t I;
+	const unsigned char *salt;
+	// NULL unless the signature is linkable
+	const public_key *tag;
+	GRPELTS2 *r;
+	unsigned char *bufs;
+	unsigned char *commitments;
+	unsigned char *commitment_randomness;
+	unsigned char *transcript;
+	unsigned char *paths;
+	int member_threads;
+	int low_memory;
+	const int *opened;
+	// the members of an execution stop as soon as the signing is cancelled
+	parallel_control *control;
+} rsign_job;
+
+static void rsign_execution(void *arg, int64_t i, int thread){
+	rsign_job *job = (rsign_job *) arg;
+	const ring_ctx *ring = job->ring;
+	int logN = ring->logN;
+	unsigned char *buf = job->bufs + thread*ring->buf_len;
+	unsigned char *commitments = job->commitments + thread*ring->commitments_len;
+	GRPELTS2 *r = job->r + i;
+
+	if (job->low_memory){
+		// only keep the root, r_i lives in a per-thread element until it is recomputed in rsign_reopen
+		r = job->r + thread;
+		commit_to_ring(job->seeds + i*SEED_BYTES, i, ring, -1, job->salt, r,
+			buf, commitments, NULL, TRANSCRIPT_ROOTS(job->transcript) + i*HASH_BYTES, NULL, job->member_threads, job->control);
+	}
+	else{
+		commit_to_ring(job->seeds + i*SEED_BYTES, i, ring, job->I, job->salt, r,
+			buf, commitments, job->commitment_randomness + i*SEED_BYTES, TRANSCRIPT_ROOTS(job->transcript) + i*HASH_BYTES, job->paths + i*HASH_BYTES*logN, job->member_threads, job->control);
 	}
 
-	return valid;
+	// compute and commit to T'
+	if (job->tag != NULL){
+		unsigned char zero_seed[SEED_BYTES] = {0};
+		XELT Tprime;
+		do_tag_action(&Tprime,job->tag,r[0]);
+		commit(&Tprime, zero_seed , job->salt, TRANSCRIPT_TPRIME(job->transcript) + i*HASH_BYTES);
+	}
+}
+
+// recomputes r_i, the commitment randomness and the path of the k-th opened execution into slot k
+static void rsign_reopen_execution(void *arg, int64_t k, int thread){
+	rsign_job *job = (rsign_job *) arg;
+	const ring_ctx *ring = job->ring;
+	int logN = ring->logN;
+	int i = job->opened[k];
+	unsigned char root[HASH_BYTES];
+
+	commit_to_ring(job->seeds + i*SEED_BYTES, i, ring, job->I, job->salt, job->r + k,
+		job->bufs + thread*ring->buf_len, job->commitments + thread*ring->commitments_len,
+		job->commitment_randomness + k*SEED_BYTES, root, job->paths + k*HASH_BYTES*logN, job->member_threads, job->control);
+}
+
+typedef struct {
+	uint64_t r;
+	uint64_t r_count;
+	uint64_t seed_tree;
+	uint64_t commitment_randomness;
+	uint64_t transcript;
+	uint64_t paths;
+	uint64_t bufs;
+	uint64_t commitments;
+} rsign_layout;
+
+static uint64_t rsign_workspace_layout(const ring_ctx *ring, int threads, int low_memory, int linkable, rsign_layout *layout){
+	int logN = ring->logN;
+	int member_threads;
+	threads = execution_threads(ring->rings, threads, &member_threads);
+
+	// in low memory mode only the opened executions keep r_i, the commitment randomness and a path
+	uint64_t kept = EXECUTIONS;
+	layout->r_count = EXECUTIONS;
+	if (low_memory){
+		kept = ZEROS;
+		layout->r_count = (threads > ZEROS) ? threads : ZEROS;
+	}
+
+	uint64_t size = 0;
+	layout->r = workspace_take(&size, sizeof(GRPELTS2)*layout->r_count);
+	layout->seed_tree = workspace_take(&size, (2*EXECUTIONS-1)*SEED_BYTES);
+	layout->commitment_randomness = workspace_take(&size, kept*SEED_BYTES);
+	layout->transcript = workspace_take(&size, TRANSCRIPT_BYTES(linkable));
+	layout->paths = workspace_take(&size, HASH_BYTES*kept*logN);
+
+	// every thread gets its own expansion buffer and commitments
+	layout->bufs = workspace_take(&size, ring->buf_len*threads);
+	layout->commitments = workspace_take(&size, ring->commitments_len*threads);
+	return size;
+}
+
+uint64_t sign_workspace_size(const int64_t rings, int threads, int low_memory, int linkable){
+	ring_ctx ring;
+	ring_ctx_view(&ring, NULL, rings);
+
+	rsign_layout layout;
+	return rsign_workspace_layout(&ring, threads, low_memory, linkable, &layout) + WORKSPACE_ALIGN;
+}
+
+uint64_t rsign_workspace_size(const int64_t rings, int threads){
+	return sign_workspace_size(rings, threads, 0, 0);
+}
+
+uint64_t rsign_lowmem_workspace_size(const int64_t rings, int threads){
+	return sign_workspace_size(rings, threads, 1, 0);
 }
 
+int rsign(const unsigned char *sk, const int64_t I, const unsigned char *pks, const int64_t rings, const unsigned char *m, uint64_t mlen, unsigned char *sig, uint64_t *sig_len){
+	return rsign_mt(sk, I, pks, rings, m, mlen, sig, sig_len, 1);
+}
+
+int rsign_mt(const unsigned char *sk, const int64_t I, const unsigned char *pks, const int64_t rings, const unsigned char *m, uint64_t mlen, unsigned char *sig, uint64_t *sig_len, int threads){
+	return rsign_ws(sk, I, pks, rings, m, mlen, sig, sig_len, threads, NULL);
+}
+
+int rsign_ws(const unsigned char *sk, const int64_t I, const unsigned char *pks, const int64_t rings, const unsigned char *m, uint64_t mlen, unsigned char *sig, uint64_t *sig_len, int threads, unsigned char *workspace){
+	rsign_presig presig;
+	if (rsign_presign(&presig, sk, I, pks, rings, threads, workspace) != 0)
+		return -1;
+
+	return rsign_finish(&presig, m, mlen, sig, sig_len);
+}
 
+int rsign_prehashed(const unsigned char *sk, const int64_t I, const unsigned char *pks, const int64_t rings, const unsigned char *message_hash, unsigned char *sig, uint64_t *sig_len, int threads, unsigned char *workspace){
+	rsign_presig presig;
+	if (rsign_presign(&presig, sk, I, pks, rings, threads, workspace) != 0)
+		return -1;
+
+	return rsign_finish_prehashed(&presig, message_hash, sig, sig_len);
+}
+
+int rsign_ctx(const unsigned char *sk, const int64_t I, const ring_ctx *ring, const unsigned char *m, uint64_t mlen, unsigned char *sig, uint64_t *sig_len, int threads, unsigned char *workspace){
+	rsign_presig presig;
+	if (sign_presign_mode(&presig, sk, I, ring, threads, workspace, 0, 0, NULL) != 0)
+		return -1;
+
+	return rsign_finish(&presig, m, mlen, sig, sig_len);
+}
+
+int rsign_lowmem(const unsigned char *sk, const int64_t I, const unsigned char *pks, const int64_t rings, const unsigned char *m, uint64_t mlen, unsigned char *sig, uint64_t *sig_len, int threads, unsigned char *workspace){
+	rsign_presig presig;
+	if (rsign_presign_lowmem(&presig, sk, I, pks, rings, threads, workspace) != 0)
+		return -1;
+
+	return rsign_finish(&presig, m, mlen, sig, sig_len);
+}
+
+// picks a fresh seed tree and computes the roots and paths of all the executions, and the T' commitments of a linkable signature
+static void rsign_commit_phase(rsign_presig *presig){
+	int member_threads;
+	int threads = execution_threads(presig->ring.rings, presig->threads, &member_threads);
+
+	// pick random seeds
+	generate_seed_tree(presig->seed_tree,EXECUTIONS,presig->salt);
+	unsigned char *seeds = presig->seed_tree + (EXECUTIONS-1)*SEED_BYTES;
+
+	rsign_job job = {seeds, &presig->ring, presig->I, presig->salt, presig->linkable ? &presig->tag : NULL, presig->r, presig->bufs, presig->commitments, presig->commitment_randomness, presig->transcript, presig->paths, member_threads, presig->low_memory, NULL, presig->control};
+
+	// the executions only depend on their own seed, so they can run in any order
+	parallel_for_control(threads, EXECUTIONS, rsign_execution, &job, presig->control);
+}
+
+// in low memory mode, recomputes what the opened executions need once the challenge is known
+static void rsign_reopen(rsign_presig *presig, const unsigned char *challenge){
+	int member_threads;
+	int threads = execution_threads(presig->ring.rings, presig->threads, &member_threads);
+	unsigned char *seeds = presig->seed_tree + (EXECUTIONS-1)*SEED_BYTES;
+
+	int opened[ZEROS];
+	int zeros = 0;
+	for (int i = 0; i < EXECUTIONS; ++i)
+	{
+		if (challenge[i] == 0)
+			opened[zeros++] = i;
+	}
+
+	rsign_job job = {seeds, &presig->ring, presig->I, presig->salt, NULL, presig->r, presig->bufs, presig->commitments, presig->commitment_randomness, presig->transcript, presig->paths, member_threads, presig->low_memory, opened, presig->control};
+	parallel_for_control(threads, ZEROS, rsign_reopen_execution, &job, presig->control);
+}
+
+int sign_presign_mode(rsign_presig *presig, const unsigned char *sk, const int64_t I, const ring_ctx *ring, int threads, unsigned char *workspace, int low_memory, int linkable, parallel_control *control){
+	memset(presig, 0, sizeof(rsign_presig));
+	presig->used = 1;
+
+	if (!ring_member(I, ring))
+		return -1;
+
+	rsign_layout layout;
+	uint64_t size = rsign_workspace_layout(ring, threads, low_memory, linkable, &layout);
+
+	if (workspace == NULL){
+		presig->allocated = malloc(size + WORKSPACE_ALIGN);
+		if (presig->allocated == NULL)
+			return -1;
+		workspace = presig->allocated;
+	}
+	workspace = workspace_align(workspace);
+
+	memcpy(presig->sk, sk, SK_BYTES);
+	presig->I = I;
+	// the presignature refers to the keys of the ring, it does not own them
+	presig->ring = *ring;
+	presig->ring.allocated = NULL;
+	presig->threads = threads;
+	presig->low_memory = low_memory;
+	presig->linkable = linkable;
+	presig->control = control;
+
+	presig->r = (GRPELTS2 *) (workspace + layout.r);
+	presig->r_count = layout.r_count;
+	presig->seed_tree = workspace + layout.seed_tree;
+	presig->commitment_randomness = workspace + layout.commitment_randomness;
+	presig->transcript = workspace + layout.transcript;
+	presig->paths = workspace + layout.paths;
+	presig->bufs = workspace + layout.bufs;
+	presig->commitments = workspace + layout.commitments;
+
+	for (int i = 0; i < presig->r_count; ++i)
+	{
+		init_grpelt(presig->r[i]);
+	}
+
+	// compute Tag
+	if (linkable){
+		GRPELTS1L s;
+		init_grpelt(s);
+		sample_S1L(s,sk);
+		derive_tag(&presig->tag,s);
+		clear_grpelt(s);
+	}
+
+	// choose salt
+	RAND_bytes(presig->salt,HASH_BYTES);
+
+	// copy salt
+	memcpy(TRANSCRIPT_SALT(presig->transcript), presig->salt, HASH_BYTES);
+
+	rsign_commit_phase(presig);
+
+	if (parallel_cancelled(control)){
+		rsign_presig_clear(presig);
+		return -1;
+	}
+
+	presig->used = 0;
+	return 0;
+}
+
+int rsign_presign(rsign_presig *presig, const unsigned char *sk, const int64_t I, const unsigned char *pks, const int64_t rings, int threads, unsigned char *workspace){
+	ring_ctx ring;
+	ring_ctx_view(&ring, pks, rings);
+	return sign_presign_mode(presig, sk, I, &ring, threads, workspace, 0, 0, NULL);
+}
+
+int rsign_presign_lowmem(rsign_presig *presig, const unsigned char *sk, const int64_t I, const unsigned char *pks, const int64_t rings, int threads, unsigned char *workspace){
+	ring_ctx ring;
+	ring_ctx_view(&ring, pks, rings);
+	return sign_presign_mode(presig, sk, I, &ring, threads, workspace, 1, 0, NULL);
+}
+
+int rsign_controlled(const unsigned char *sk, const int64_t I, const unsigned char *pks, const int64_t rings, const unsigned char *message_hash, unsigned char *sig, uint64_t *sig_len, int threads, parallel_control *control){
+	ring_ctx ring;
+	ring_ctx_view(&ring, pks, rings);
+
+	rsign_presig presig;
+	if (sign_presign_mode(&presig, sk, I, &ring, threads, NULL, 0, 0, control) != 0)
+		return -1;
+
+	return rsign_finish_prehashed(&presig, message_hash, sig, sig_len);
+}
+
+// derives the challenge from the transcript and packs the tag and the responses,
+// returns -1 without touching sig_len if one of the responses is rejected
+static int rsign_respond(rsign_presig *presig, unsigned char *sig, uint64_t *sig_len){
+	int logN = presig->ring.logN;
+	GRPELTS2 *r = presig->r;
+	unsigned char *transcript = presig->transcript;
+	int rejected = 0;
+
+	// the commitments may be incomplete once cancelled
+	if (parallel_cancelled(presig->control))
+		return -1;
+
+	// generate response
+	GRPELTS2 z;
+	GRPELTS1L s;
+	init_grpelt(z);
+	init_grpelt(s);
+	if (presig->linkable){
+		sample_S1L(s,presig->sk);
+	}
+	else{
+		sample_S1(s,presig->sk);
+	}
+
+	// copy tag, the rest of the signature is laid out as a ring signature
+	if (presig->linkable)
+		memcpy(sig, &presig->tag, PK_BYTES);
+	sig += SIG_TAG_BYTES(presig->linkable);
+
+	// copy salt
+	*RSIG_FORMAT(sig) = SIG_FORMAT;
+	memcpy(RSIG_SALT(sig), presig->salt, HASH_BYTES);
+
+	unsigned char challenge[EXECUTIONS];
+	int zeros;
+
+	// generate challenge
+	EXPAND(transcript, TRANSCRIPT_BYTES(presig->linkable), RSIG_CHALLENGE(sig), SEED_BYTES);
+	derive_challenge(RSIG_CHALLENGE(sig),challenge);
+
+	if (presig->low_memory){
+		rsign_reopen(presig, challenge);
+	}
+
+	if (parallel_cancelled(presig->control)){
+		clear_grpelt(z);
+		clear_grpelt(s);
+		return -1;
+	}
+
+	zeros = 0;
+	for (int i = 0; i < EXECUTIONS; ++i)
+	{
+		if (challenge[i] == 0)
+		{
+			// in low memory mode the opened executions are stored in order
+			int slot = presig->low_memory ? zeros : i;
+
+			// compute and pack z in signature
+			add(z, s, r[slot]);
+			if( !is_in_S3(z) ){
+				rejected = 1;
+				break;
+			}
+
+			#ifdef BG
+			XELT W;
+			do_action(&W,&X0,z);
+			if( !bg_check(&W) ){
+				rejected = 1;
+				break;
+			}
+			if (presig->linkable){
+				do_tag_action(&W,&X0,z);
+				if( !bg_check(&W) ){
+					rejected = 1;
+					break;
+				}
+			}
+			#endif
+
+			pack_S3(RSIG_Z(sig) + zeros*S3_BYTES, z);
+
+			// copy commitment randomess to signature
+			memcpy(RSIG_COMMITMENT_RANDOMNESS(sig) + zeros*SEED_BYTES, presig->commitment_randomness + slot*SEED_BYTES, SEED_BYTES);
+			// copy Merkle tree path to signature
+			memcpy(RSIG_PATHS(sig) + zeros*logN*HASH_BYTES, presig->paths + slot*HASH_BYTES*logN, HASH_BYTES*logN);
+			zeros++;
+		}
+	}
+
+	if (!rejected){
+		release_seeds(presig->seed_tree, EXECUTIONS, challenge, RSIG_SEEDS(sig,logN) , sig_len );
+		(*sig_len) *= SEED_BYTES;
+		(*sig_len) += SIG_TAG_BYTES(presig->linkable) + RSIG_SEEDS(0,logN);
+	}
+
+	clear_grpelt(z);
+	clear_grpelt(s);
+
+	return rejected ? -1 : 0;
+}
+
+int rsign_finish(rsign_presig *presig, const unsigned char *m, uint64_t mlen, unsigned char *sig, uint64_t *sig_len){
+	// hash message
+	unsigned char message_hash[HASH_BYTES];
+	HASH(m,mlen,message_hash);
+
+	return rsign_finish_prehashed(presig, message_hash, sig, sig_len);
+}
+
+int rsign_finish_prehashed(rsign_presig *presig, const unsigned char *message_hash, unsigned char *sig, uint64_t *sig_len){
+	// a presignature must never be used for two messages
+	if (presig->used)
+		return -1;
+	presig->used = 1;
+
+	memcpy(TRANSCRIPT_MESSAGE_HASH(presig->transcript), message_hash, HASH_BYTES);
+
+	while (rsign_respond(presig, sig, sig_len) != 0){
+		if (parallel_cancelled(presig->control)){
+			rsign_presig_clear(presig);
+			return -1;
+		}
+
+		restarts += 1;
+		rsign_commit_phase(presig);
+	}
+
+	rsign_presig_clear(presig);
+	return 0;
+}
+
+typedef struct {
+	const unsigned char *sk;
+	int64_t I;
+	const ring_ctx *ring;
+	const unsigned char *message_hash;
+	int threads;
+	int linkable;
+	uint64_t sig_bytes;
+	rsign_presig *presigs;
+	unsigned char *sigs;
+	uint64_t *sig_lens;
+	int *results;
+} rsign_candidate_job;
+
+// a candidate is -1 once rejected and -2 if it could not be presigned at all
+static void rsign_candidate(void *arg, int64_t c, int thread){
+	rsign_candidate_job *job = (rsign_candidate_job *) arg;
+	rsign_presig *presig = job->presigs + c;
+
+	job->results[c] = -2;
+	if (sign_presign_mode(presig, job->sk, job->I, job->ring, job->threads, NULL, 0, job->linkable, NULL) != 0)
+		return;
+
+	memcpy(TRANSCRIPT_MESSAGE_HASH(presig->transcript), job->message_hash, HASH_BYTES);
+	job->results[c] = rsign_respond(presig, job->sigs + c*job->sig_bytes, job->sig_lens + c);
+}
+
+int sign_speculative(const unsigned char *sk, const int64_t I, const ring_ctx *ring, const unsigned char *m, uint64_t mlen, unsigned char *sig, uint64_t *sig_len, int threads, int candidates, int linkable){
+	if (!ring_member(I, ring))
+		return -1;
+
+	if (candidates < 1)
+		candidates = 1;
+	if (threads < 1)
+		threads = 1;
+
+	int candidate_threads = threads/candidates;
+	if (candidate_threads < 1)
+		candidate_threads = 1;
+
+	unsigned char message_hash[HASH_BYTES];
+	HASH(m,mlen,message_hash);
+
+	// the tag in a presignature needs to be aligned
+	uint64_t sig_bytes = SIG_TAG_BYTES(linkable) + RSIG_BYTES(ring->logN);
+	uint64_t presigs_size = 0;
+	workspace_take(&presigs_size, sizeof(rsign_presig)*candidates);
+	rsign_presig *presigs = aligned_alloc(WORKSPACE_ALIGN, presigs_size);
+	unsigned char *sigs = malloc(sig_bytes*candidates);
+	uint64_t *sig_lens = malloc(sizeof(uint64_t)*candidates);
+	int *results = malloc(sizeof(int)*candidates);
+
+	rsign_candidate_job job = {sk, I, ring, message_hash, candidate_threads, linkable, sig_bytes, presigs, sigs, sig_lens, results};
+
+	int found = (presigs == NULL || sigs == NULL || sig_lens == NULL || results == NULL) ? -1 : 0;
+	while (!found){
+		parallel_for(threads, candidates, rsign_candidate, &job);
+
+		// taking the first accepted candidate in order gives the same distribution as restarting one at a time
+		for (int c = 0; c < candidates; ++c)
+		{
+			rsign_presig_clear(presigs + c);
+			if (found)
+				continue;
+
+			if (results[c] == 0){
+				memcpy(sig, sigs + c*sig_bytes, sig_lens[c]);
+				*sig_len = sig_lens[c];
+				found = 1;
+			}
+			else if (results[c] == -2){
+				found = -1;
+			}
+			else{
+				restarts += 1;
+			}
+		}
+	}
+
+	free(presigs);
+	free(sigs);
+	free(sig_lens);
+	free(results);
+
+	return (found == 1) ? 0 : -1;
+}
+
+int rsign_speculative(const unsigned char *sk, const int64_t I, const unsigned char *pks, const int64_t rings, const unsigned char *m, uint64_t mlen, unsigned char *sig, uint64_t *sig_len, int threads, int candidates){
+	ring_ctx ring;
+	ring_ctx_view(&ring, pks, rings);
+	return sign_speculative(sk, I, &ring, m, mlen, sig, sig_len, threads, candidates, 0);
+}
+
+void rsign_presig_clear(rsign_presig *presig){
+	if (presig->r != NULL){
+		for (int i = 0; i < presig->r_count; ++i)
+		{
+			clear_grpelt(presig->r[i]);
+		}
+	}
+
+	free(presig->allocated);
+
+	memset(presig, 0, sizeof(rsign_presig));
+	presig->used = 1;
+}
+
+typedef struct {
+	const unsigned char *seeds;
+	const ring_ctx *ring;
+	const unsigned char *sig;
+	const unsigned char *challenge;
+	const int *zero_index;
+	GRPELTS2 *r;
+	GRPELTS2 *z;
+	unsigned char *bufs;
+	unsigned char *commitments;
+	unsigned char *transcript;
+	int member_threads;
+	// an aligned copy of the tag of a linkable signature, NULL otherwise
+	const public_key *tag;
+	atomic_int invalid;
+	// the control of the call, or the one of the budget that is chained to it. its cycles are the ones spent on the executions
+	parallel_control *control;
+} rverify_job;
+
+// recomputes the root of an opened execution from z, and its T' commitment for a linkable signature,
+// returns -1 if z is not in S3. sig points past the tag
+static int rverify_opened(const unsigned char *sig, int i, int zeros, int logN, GRPELTS2 *z, unsigned char *commitment, unsigned char *transcript, int linkable){
+	XELT R;
+
+	// unpack z
+	unpack_S3(RSIG_Z(sig) + zeros*S3_BYTES, z[0]);
+
+	if(!is_in_S3(z[0])){
+		printf("z not in S3! \n");
+		return -1;
+	}
+
+	// compute z*X_0
+	do_action(&R,&X0,z[0]);
+
+	// commit to it
+	commit(&R,RSIG_COMMITMENT_RANDOMNESS(sig) + SEED_BYTES*zeros, RSIG_SALT(sig), commitment);
+	// reconstruct root
+	reconstruct_root(commitment, RSIG_PATHS(sig) + zeros*logN*HASH_BYTES, logN, TRANSCRIPT_ROOTS(transcript) + i*HASH_BYTES);
+
+	// compute z \bullet T_0 and commit to it
+	if (linkable){
+		unsigned char zero_seed[SEED_BYTES] = {0};
+		do_tag_action(&R,&X0,z[0]);
+		commit(&R, zero_seed , RSIG_SALT(sig), TRANSCRIPT_TPRIME(transcript) + i*HASH_BYTES);
+	}
+	return 0;
+}
+
+static void rverify_execution(void *arg, int64_t i, int thread){
+	rverify_job *job = (rverify_job *) arg;
+	const unsigned char *sig = job->sig;
+	const ring_ctx *ring = job->ring;
+	int logN = ring->logN;
+	unsigned char *commitments = job->commitments + thread*ring->commitments_len;
+
+	// no need to continue once one of the executions is rejected
+	if (atomic_load(&job->invalid))
+		return;
+
+	uint64_t start = cpu_cycles();
+	if (job->challenge[i] == 0){
+		if (rverify_opened(sig, i, job->zero_index[i], logN, job->z + thread, commitments, job->transcript, job->tag != NULL) != 0)
+			atomic_store(&job->invalid, 1);
+	}
+	else{
+		// compute root
+		commit_to_ring(job->seeds + i*SEED_BYTES, i, ring, -1, RSIG_SALT(sig), job->r + thread,
+			job->bufs + thread*ring->buf_len, commitments, NULL, TRANSCRIPT_ROOTS(job->transcript) + i*HASH_BYTES, NULL, job->member_threads, job->control);
+		// commit_to_ring charged its own cycles
+		start = cpu_cycles();
+
+		// compute and commit to T'
+		if (job->tag != NULL){
+			unsigned char zero_seed[SEED_BYTES] = {0};
+			XELT Tprime;
+			do_tag_action(&Tprime,job->tag,job->r[thread]);
+			commit(&Tprime, zero_seed , RSIG_SALT(sig), TRANSCRIPT_TPRIME(job->transcript) + i*HASH_BYTES);
+		}
+	}
+
+	parallel_charge(job->control, cpu_cycles() - start);
+}
+
+// expands the challenge and the released seeds of a signature and puts the message hash and salt in the transcript,
+// sig points past the tag
+static void rverify_prepare(const unsigned char *sig, int logN, const unsigned char *message_hash, unsigned char *challenge, int *zero_index, unsigned char *seed_tree, unsigned char *transcript){
+	// expand challenge
+	derive_challenge(RSIG_CHALLENGE(sig),challenge);
+
+	// position of each execution among the zeros of the challenge
+	int zeros = 0;
+	for (int i = 0; i < EXECUTIONS; ++i)
+	{
+		zero_index[i] = zeros;
+		zeros += (challenge[i] == 0);
+	}
+
+	// derive seeds
+	uint64_t nodes_used;
+	fill_down(seed_tree,EXECUTIONS, challenge, RSIG_SEEDS(sig,logN), &nodes_used, RSIG_SALT(sig));
+
+	// copy message hash and salt
+	memcpy(TRANSCRIPT_MESSAGE_HASH(transcript), message_hash, HASH_BYTES);
+	memcpy(TRANSCRIPT_SALT(transcript), RSIG_SALT(sig), HASH_BYTES);
+}
+
+// checks that the reconstructed transcript hashes to the challenge seed of the signature, sig points past the tag
+static int rverify_check_transcript(const unsigned char *sig, const unsigned char *transcript, int linkable){
+	unsigned char challenge_seed[SEED_BYTES];
+	EXPAND(transcript, TRANSCRIPT_BYTES(linkable), challenge_seed, SEED_BYTES);
+
+	if(memcmp(RSIG_CHALLENGE(sig) , challenge_seed, SEED_BYTES) != 0){
+		printf("challenge seed does not match! \n");
+		return -1;
+	}
+	return 0;
+}
+
+typedef struct {
+	uint64_t challenge;
+	uint64_t zero_index;
+	uint64_t seed_tree;
+	uint64_t transcript;
+	uint64_t r;
+	uint64_t z;
+	uint64_t bufs;
+	uint64_t commitments;
+} rverify_layout;
+
+static uint64_t rverify_workspace_layout(const ring_ctx *ring, int threads, int linkable, rverify_layout *layout){
+	int member_threads;
+	threads = execution_threads(ring->rings, threads, &member_threads);
+
+	uint64_t size = 0;
+	layout->challenge = workspace_take(&size, EXECUTIONS);
+	layout->zero_index = workspace_take(&size, sizeof(int)*EXECUTIONS);
+	layout->seed_tree = workspace_take(&size, (2*EXECUTIONS-1)*SEED_BYTES);
+	layout->transcript = workspace_take(&size, TRANSCRIPT_BYTES(linkable));
+
+	// every thread gets its own r, z, expansion buffer and commitments
+	layout->r = workspace_take(&size, sizeof(GRPELTS2)*threads);
+	layout->z = workspace_take(&size, sizeof(GRPELTS2)*threads);
+	layout->bufs = workspace_take(&size, ring->buf_len*threads);
+	layout->commitments = workspace_take(&size, ring->commitments_len*threads);
+	return size;
+}
+
+uint64_t verify_workspace_size(const int64_t rings, int threads, int linkable){
+	ring_ctx ring;
+	ring_ctx_view(&ring, NULL, rings);
+
+	rverify_layout layout;
+	return rverify_workspace_layout(&ring, threads, linkable, &layout) + WORKSPACE_ALIGN;
+}
+
+uint64_t rverify_workspace_size(const int64_t rings, int threads){
+	return verify_workspace_size(rings, threads, 0);
+}
+
+int  rverify(const unsigned char *pks, const int64_t rings, const unsigned char *m, uint64_t mlen, const unsigned char *sig){
+	return rverify_mt(pks, rings, m, mlen, sig, 1);
+}
+
+int  rverify_mt(const unsigned char *pks, const int64_t rings, const unsigned char *m, uint64_t mlen, const unsigned char *sig, int threads){
+	return rverify_ws(pks, rings, m, mlen, sig, threads, NULL);
+}
+
+int  rverify_ws(const unsigned char *pks, const int64_t rings, const unsigned char *m, uint64_t mlen, const unsigned char *sig, int threads, unsigned char *workspace){
+	// hash message
+	unsigned char message_hash[HASH_BYTES];
+	HASH(m,mlen,message_hash);
+
+	return rverify_prehashed(pks, rings, message_hash, sig, threads, workspace);
+}
+
+int verify_run(const ring_ctx *ring, const unsigned char *message_hash, const unsigned char *sig, int threads, unsigned char *workspace, parallel_control *control, const verify_budget *budget, int linkable){
+	if (ring->rings < 1)
+		return -1;
+	if (*RSIG_FORMAT(sig + SIG_TAG_BYTES(linkable)) != SIG_FORMAT)
+		return VERIFY_FORMAT_MISMATCH;
+
+	rverify_layout layout;
+	uint64_t size = rverify_workspace_layout(ring, threads, linkable, &layout);
+
+	if (workspace == NULL){
+		unsigned char *allocated = malloc(size + WORKSPACE_ALIGN);
+		if (allocated == NULL)
+			return -1;
+		int valid = verify_run(ring, message_hash, sig, threads, allocated, control, budget, linkable);
+		free(allocated);
+		return valid;
+	}
+
+	int logN = ring->logN;
+	workspace = workspace_align(workspace);
+
+	int member_threads;
+	threads = execution_threads(ring->rings, threads, &member_threads);
+
+	// the tag is not necessarily aligned within the signature
+	public_key tag;
+	if (linkable)
+		memcpy(&tag, sig, PK_BYTES);
+	sig += SIG_TAG_BYTES(linkable);
+
+	unsigned char *challenge = workspace + layout.challenge;
+	int *zero_index = (int *) (workspace + layout.zero_index);
+	unsigned char *seed_tree = workspace + layout.seed_tree;
+	unsigned char *seeds = seed_tree + (EXECUTIONS-1)*SEED_BYTES;
+	unsigned char *transcript = workspace + layout.transcript;
+	rverify_prepare(sig, logN, message_hash, challenge, zero_index, seed_tree, transcript);
+
+	// reconstruct roots
+	GRPELTS2 *r = (GRPELTS2 *) (workspace + layout.r);
+	GRPELTS2 *z = (GRPELTS2 *) (workspace + layout.z);
+	for (int t = 0; t < threads; ++t)
+	{
+		init_grpelt(r[t]);
+		init_grpelt(z[t]);
+	}
+
+	// a budget stops the executions, and the ring members of an execution, through a control of its own. the control
+	// of the caller is its parent, so using up the budget does not cancel other work that shares the caller's control
+	parallel_control budget_control;
+	parallel_control *caller_control = control;
+	if (budget != NULL){
+		parallel_control_init_child(&budget_control, control);
+		budget_control.limit = verify_budget_limit;
+		budget_control.limit_arg = budget;
+		control = &budget_control;
+	}
+
+	rverify_job job = {seeds, ring, sig, challenge, zero_index, r, z, workspace + layout.bufs, workspace + layout.commitments, transcript, member_threads, linkable ? &tag : NULL};
+	job.control = control;
+	atomic_init(&job.invalid, 0);
+
+	parallel_for_control(threads, EXECUTIONS, rverify_execution, &job, control);
+
+	int valid = atomic_load(&job.invalid) ? -1 : 0;
+	int exhausted = budget != NULL && atomic_load(&budget_control.cancelled);
+	int cancelled = parallel_cancelled(caller_control);
+
+	for (int t = 0; t < threads; ++t)
+	{
+		clear_grpelt(r[t]);
+		clear_grpelt(z[t]);
+	}
+
+	if (valid != 0)
+		return -1;
+	if (exhausted && !cancelled)
+		return VERIFY_BUDGET_EXCEEDED;
+	if (cancelled)
+		return -1;
+
+	// check hash of the transcript
+	if (rverify_check_transcript(sig, transcript, linkable) != 0)
+		return -1;
+
+	return valid;
+}
+
+int  rverify_prehashed(const unsigned char *pks, const int64_t rings, const unsigned char *message_hash, const unsigned char *sig, int threads, unsigned char *workspace){
+	ring_ctx ring;
+	ring_ctx_view(&ring, pks, rings);
+	return verify_run(&ring, message_hash, sig, threads, workspace, NULL, NULL, 0);
+}
+
+int  rverify_controlled(const unsigned char *pks, const int64_t rings, const unsigned char *message_hash, const unsigned char *sig, int threads, parallel_control *control){
+	ring_ctx ring;
+	ring_ctx_view(&ring, pks, rings);
+	return verify_run(&ring, message_hash, sig, threads, NULL, control, NULL, 0);
+}
+
+// checks the length of the signature against its challenge, the tag of a linkable signature and that all the responses are in S3
+static int rverify_check_structure(const unsigned char *sig, uint64_t sig_len, int logN, int linkable){
+	if (sig_len < SIG_TAG_BYTES(linkable) + RSIG_SEEDS(0,logN))
+		return -1;
+	if (*RSIG_FORMAT(sig + SIG_TAG_BYTES(linkable)) != SIG_FORMAT)
+		return VERIFY_FORMAT_MISMATCH;
+
+	if (linkable){
+		// the tag is not necessarily aligned within the signature
+		public_key tag;
+		memcpy(&tag, sig, PK_BYTES);
+		if (!is_valid_pk(&tag))
+			return -1;
+	}
+	sig += SIG_TAG_BYTES(linkable);
+
+	unsigned char challenge[EXECUTIONS];
+	derive_challenge(RSIG_CHALLENGE(sig),challenge);
+	if (sig_len != SIG_TAG_BYTES(linkable) + RSIG_SEEDS(0,logN) + SEED_BYTES*count_released_seeds(EXECUTIONS, challenge))
+		return -1;
+
+	int valid = 0;
+	GRPELTS2 z;
+	init_grpelt(z);
+	for (int k = 0; k < ZEROS && valid == 0; ++k)
+	{
+		unpack_S3(RSIG_Z(sig) + k*S3_BYTES, z);
+		if (!is_in_S3(z))
+			valid = -1;
+	}
+	clear_grpelt(z);
+	return valid;
+}
+
+int  rverify_bounded(const unsigned char *pks, const int64_t rings, const unsigned char *m, uint64_t mlen, const unsigned char *sig, uint64_t sig_len, int threads, const verify_budget *budget){
+	unsigned char message_hash[HASH_BYTES];
+	HASH(m,mlen,message_hash);
+
+	return rverify_bounded_prehashed(pks, rings, message_hash, sig, sig_len, threads, budget);
+}
+
+int verify_bounded_prehashed(const ring_ctx *ring, const unsigned char *message_hash, const unsigned char *sig, uint64_t sig_len, int threads, const verify_budget *budget, int linkable){
+	if (ring->rings < 1)
+		return -1;
+
+	int valid = rverify_check_structure(sig, sig_len, ring->logN, linkable);
+	if (valid != 0)
+		return valid;
+
+	return verify_run(ring, message_hash, sig, threads, NULL, NULL, budget, linkable);
+}
+
+int  rverify_bounded_prehashed(const unsigned char *pks, const int64_t rings, const unsigned char *message_hash, const unsigned char *sig, uint64_t sig_len, int threads, const verify_budget *budget){
+	ring_ctx ring;
+	ring_ctx_view(&ring, pks, rings);
+	return verify_bounded_prehashed(&ring, message_hash, sig, sig_len, threads, budget, 0);
+}
+
+int  rverify_ctx(const ring_ctx *ring, const unsigned char *m, uint64_t mlen, const unsigned char *sig, int threads, unsigned char *workspace){
+	// hash message
+	unsigned char message_hash[HASH_BYTES];
+	HASH(m,mlen,message_hash);
+
+	return verify_run(ring, message_hash, sig, threads, workspace, NULL, NULL, 0);
+}
+
+// the tag and T' commitment of an unopened execution of a linkable signature in a tile
+typedef struct {
+	const public_key *tag;
+	unsigned char *tprime;
+} rverify_unopened;
+
+typedef struct {
+	const ring_ctx *ring;
+	const unsigned char *const *sigs;
+	const int *zero_indices;
+	unsigned char *transcripts;
+	const ring_commitment *tiles;
+	// NULL unless the signatures are linkable
+	const rverify_unopened *unopened;
+	int tile_count;
+	const int *opened;
+	GRPELTS2 *r;
+	GRPELTS2 *z;
+	unsigned char *bufs;
+	unsigned char *commitments;
+	atomic_int *invalid;
+	int linkable;
+} rverify_batch_job;
+
+// the first tile_count indices are tiles of unopened executions, the others are opened executions
+static void rverify_batch_task(void *arg, int64_t index, int thread){
+	rverify_batch_job *job = (rverify_batch_job *) arg;
+	const ring_ctx *ring = job->ring;
+	int logN = ring->logN;
+	unsigned char *commitments = job->commitments + thread*VERIFY_TILE*HASH_BYTES*ring->nodes;
+
+	if (index < job->tile_count){
+		const ring_commitment *tile = job->tiles + index*VERIFY_TILE;
+		GRPELTS2 *r = job->r + thread*VERIFY_TILE;
+		int count = 0;
+		while (count < VERIFY_TILE && tile[count].root != NULL)
+			count++;
+
+		commit_to_ring_tile(tile, count, ring, r, job->bufs + thread*VERIFY_TILE*ring->buf_len, commitments);
+
+		// compute and commit to T'
+		if (job->unopened != NULL){
+			const rverify_unopened *unopened = job->unopened + index*VERIFY_TILE;
+			unsigned char zero_seed[SEED_BYTES] = {0};
+			XELT Tprime;
+			for (int t = 0; t < count; ++t)
+			{
+				do_tag_action(&Tprime,unopened[t].tag,r[t]);
+				commit(&Tprime, zero_seed , tile[t].salt, unopened[t].tprime);
+			}
+		}
+		return;
+	}
+
+	int s = job->opened[2*(index - job->tile_count)];
+	int i = job->opened[2*(index - job->tile_count) + 1];
+
+	// no need to continue once the signature is rejected
+	if (atomic_load(&job->invalid[s]))
+		return;
+
+	if (rverify_opened(job->sigs[s] + SIG_TAG_BYTES(job->linkable), i, job->zero_indices[s*EXECUTIONS + i], logN, job->z + thread, commitments, job->transcripts + s*TRANSCRIPT_BYTES(job->linkable), job->linkable) != 0)
+		atomic_store(&job->invalid[s], 1);
+}
+
+typedef struct {
+	uint64_t challenges;
+	uint64_t zero_indices;
+	uint64_t seed_trees;
+	uint64_t transcripts;
+	uint64_t tags;
+	uint64_t invalid;
+	uint64_t tiles;
+	uint64_t unopened;
+	uint64_t opened;
+	uint64_t r;
+	uint64_t z;
+	uint64_t bufs;
+	uint64_t commitments;
+} rverify_batch_layout;
+
+static uint64_t rverify_batch_workspace_layout(const ring_ctx *ring, int threads, int count, int linkable, rverify_batch_layout *layout){
+	uint64_t size = 0;
+	layout->challenges = workspace_take(&size, EXECUTIONS*count);
+	layout->zero_indices = workspace_take(&size, sizeof(int)*EXECUTIONS*count);
+	layout->seed_trees = workspace_take(&size, (2*EXECUTIONS-1)*SEED_BYTES*count);
+	layout->transcripts = workspace_take(&size, TRANSCRIPT_BYTES(linkable)*count);
+	layout->tags = workspace_take(&size, linkable ? sizeof(public_key)*count : 0);
+	layout->invalid = workspace_take(&size, sizeof(atomic_int)*count);
+
+	// the unopened executions of all signatures are packed in tiles, the last one may not be full
+	layout->tiles = workspace_take(&size, sizeof(ring_commitment)*(ONES*count + VERIFY_TILE));
+	layout->unopened = workspace_take(&size, linkable ? sizeof(rverify_unopened)*(ONES*count + VERIFY_TILE) : 0);
+	layout->opened = workspace_take(&size, 2*sizeof(int)*ZEROS*count);
+
+	// every thread gets its own z and r, expansion buffers and commitments for a tile
+	layout->r = workspace_take(&size, sizeof(GRPELTS2)*VERIFY_TILE*threads);
+	layout->z = workspace_take(&size, sizeof(GRPELTS2)*threads);
+	layout->bufs = workspace_take(&size, ring->buf_len*VERIFY_TILE*threads);
+	layout->commitments = workspace_take(&size, HASH_BYTES*ring->nodes*VERIFY_TILE*threads);
+	return size;
+}
+
+// verifies up to VERIFY_BATCH_SIGNATURES signatures with a single schedule of all their executions
+static void rverify_batch_chunk(const ring_ctx *ring, const unsigned char *const *ms, const uint64_t *mlens, const unsigned char *const *sigs, int count, int *results, int threads, unsigned char *workspace, int linkable){
+	int logN = ring->logN;
+
+	rverify_batch_layout layout;
+	rverify_batch_workspace_layout(ring, threads, count, linkable, &layout);
+	workspace = workspace_align(workspace);
+
+	unsigned char *challenges = workspace + layout.challenges;
+	int *zero_indices = (int *) (workspace + layout.zero_indices);
+	unsigned char *seed_trees = workspace + layout.seed_trees;
+	unsigned char *transcripts = workspace + layout.transcripts;
+	public_key *tags = (public_key *) (workspace + layout.tags);
+	atomic_int *invalid = (atomic_int *) (workspace + layout.invalid);
+	ring_commitment *tiles = (ring_commitment *) (workspace + layout.tiles);
+	rverify_unopened *unopened = (rverify_unopened *) (workspace + layout.unopened);
+	int *opened = (int *) (workspace + layout.opened);
+
+	int tile_count = 0;
+	int opened_count = 0;
+	int in_tile = 0;
+	for (int s = 0; s < count; ++s)
+	{
+		const unsigned char *sig = sigs[s] + SIG_TAG_BYTES(linkable);
+		unsigned char *challenge = challenges + s*EXECUTIONS;
+		unsigned char *seeds = seed_trees + s*(2*EXECUTIONS-1)*SEED_BYTES + (EXECUTIONS-1)*SEED_BYTES;
+		unsigned char *transcript = transcripts + s*TRANSCRIPT_BYTES(linkable);
+		atomic_init(&invalid[s], 0);
+
+		// a signature of another format variant takes no part in the batch
+		if (*RSIG_FORMAT(sig) != SIG_FORMAT)
+			continue;
+
+		unsigned char message_hash[HASH_BYTES];
+		HASH(ms[s],mlens[s],message_hash);
+		rverify_prepare(sig, logN, message_hash, challenge, zero_indices + s*EXECUTIONS, seed_trees + s*(2*EXECUTIONS-1)*SEED_BYTES, transcript);
+
+		// the tags are copied out of the signatures, which need not be aligned
+		if (linkable)
+			memcpy(&tags[s], sigs[s], PK_BYTES);
+
+		// group the unopened executions of all signatures in tiles
+		for (int i = 0; i < EXECUTIONS; ++i)
+		{
+			if (challenge[i] == 0){
+				opened[2*opened_count] = s;
+				opened[2*opened_count + 1] = i;
+				opened_count++;
+				continue;
+			}
+
+			if (in_tile == 0)
+				tile_count++;
+
+			int k = (tile_count-1)*VERIFY_TILE + in_tile;
+			tiles[k].seed = seeds + i*SEED_BYTES;
+			tiles[k].i = i;
+			tiles[k].salt = RSIG_SALT(sig);
+			tiles[k].root = TRANSCRIPT_ROOTS(transcript) + i*HASH_BYTES;
+			if (linkable){
+				unopened[k].tag = &tags[s];
+				unopened[k].tprime = TRANSCRIPT_TPRIME(transcript) + i*HASH_BYTES;
+			}
+			in_tile = (in_tile + 1) % VERIFY_TILE;
+		}
+	}
+
+	// mark the end of the last tile
+	if (in_tile != 0)
+		tiles[(tile_count-1)*VERIFY_TILE + in_tile].root = NULL;
+
+	GRPELTS2 *r = (GRPELTS2 *) (workspace + layout.r);
+	GRPELTS2 *z = (GRPELTS2 *) (workspace + layout.z);
+	for (int t = 0; t < threads; ++t)
+	{
+		for (int k = 0; k < VERIFY_TILE; ++k)
+		{
+			init_grpelt(r[t*VERIFY_TILE + k]);
+		}
+		init_grpelt(z[t]);
+	}
+
+	rverify_batch_job job = {ring, sigs, zero_indices, transcripts, tiles, linkable ? unopened : NULL, tile_count, opened, r, z, workspace + layout.bufs, workspace + layout.commitments, invalid, linkable};
+
+	// the tiles are the expensive tasks, so they are handed out first
+	parallel_for(threads, tile_count + opened_count, rverify_batch_task, &job);
+
+	for (int t = 0; t < threads; ++t)
+	{
+		for (int k = 0; k < VERIFY_TILE; ++k)
+		{
+			clear_grpelt(r[t*VERIFY_TILE + k]);
+		}
+		clear_grpelt(z[t]);
+	}
+
+	for (int s = 0; s < count; ++s)
+	{
+		if (*RSIG_FORMAT(sigs[s] + SIG_TAG_BYTES(linkable)) != SIG_FORMAT){
+			results[s] = VERIFY_FORMAT_MISMATCH;
+			continue;
+		}
+
+		results[s] = atomic_load(&invalid[s]) ? -1 : 0;
+
+		// check hash of the transcript
+		if (rverify_check_transcript(sigs[s] + SIG_TAG_BYTES(linkable), transcripts + s*TRANSCRIPT_BYTES(linkable), linkable) != 0)
+			results[s] = -1;
+	}
+}
+
+int verify_batch(const ring_ctx *ring, const unsigned char *const *ms, const uint64_t *mlens, const unsigned char *const *sigs, int count, int *results, int threads, int linkable){
+	if (threads < 1)
+		threads = 1;
+
+	int chunk = (count < VERIFY_BATCH_SIGNATURES) ? count : VERIFY_BATCH_SIGNATURES;
+	rverify_batch_layout layout;
+	unsigned char *workspace = NULL;
+
+	// the tiles need the commitments of whole rings, streamed rings are verified one signature at a time
+	if (ring->rings >= 1 && !ring->streaming)
+		workspace = malloc(rverify_batch_workspace_layout(ring, threads, chunk, linkable, &layout) + WORKSPACE_ALIGN);
+
+	int valid = 0;
+	for (int s = 0; s < count; s += chunk)
+	{
+		int n = (count - s < chunk) ? count - s : chunk;
+		if (workspace != NULL){
+			rverify_batch_chunk(ring, ms + s, mlens + s, sigs + s, n, results + s, threads, workspace, linkable);
+		}
+		else{
+			for (int k = s; k < s + n; ++k)
+			{
+				unsigned char message_hash[HASH_BYTES];
+				HASH(ms[k],mlens[k],message_hash);
+				results[k] = verify_run(ring, message_hash, sigs[k], threads, NULL, NULL, NULL, linkable);
+			}
+		}
+
+		for (int k = s; k < s + n; ++k)
+		{
+			if (results[k] != 0)
+				valid = -1;
+		}
+	}
+
+	free(workspace);
+	return valid;
+}
+
+int  rverify_batch(const unsigned char *pks, const int64_t rings, const unsigned char *const *ms, const uint64_t *mlens, const unsigned char *const *sigs, int count, int *results, int threads){
+	ring_ctx ring;
+	ring_ctx_view(&ring, pks, rings);
+	return verify_batch(&ring, ms, mlens, sigs, count, results, threads, 0);
+}
@@ -3,15 +3,67 @@
 
 #include "parameters.h"
 #include "seedtree.h"
+#include "parallel.h"
+#include "hash_lanes.h"
 #include "stdint.h"
 
 #define SEED_BUF_BYTES (HASH_BYTES + SEED_BYTES + sizeof(uint32_t))
 
 #define SK_BYTES SEED_BYTES
 
+// ring members are committed to in chunks of MEMBER_CHUNK when they are split over threads
+#define MEMBER_CHUNK 8
+#define MEMBER_SPLIT_RING_SIZE (1 << 12)
+#define MIN_EXECUTIONS_PER_THREAD 16
+
+// batch verification commits to VERIFY_TILE executions per pass over the public keys,
+// and schedules the executions of up to VERIFY_BATCH_SIGNATURES signatures together
+#define VERIFY_TILE 8
+#define VERIFY_BATCH_SIGNATURES 16
+
+// number of hashes computed in parallel by commit_batch and build_tree_and_path
+#define COMMIT_LANES HASH_LANES
+
+// the Merkle tree of a ring is padded to a power of two leaves with dummy commitments. with UNPADDED_TREE a level
+// with an odd number of nodes gets a single dummy node instead, this changes the roots but not the length of the paths
+#ifndef UNPADDED_TREE
+	#define UNPADDED_TREE 0
+#endif
+#if UNPADDED_TREE
+	#define RING_TREE_LEAVES(rings) (rings)
+	#define RING_TREE_NODES(rings) ((rings) + log_round_up(rings))
+#else
+	#define RING_TREE_LEAVES(rings) (((int64_t) 1) << log_round_up(rings))
+	#define RING_TREE_NODES(rings) RING_TREE_LEAVES(rings)
+#endif
+
+// the commitment randomness of the ring members is one expansion of the execution seed. with COUNTER_RANDOMNESS
+// the randomness of every member and every dummy node is derived on its own from its index, so no expansion buffer is needed
+#ifndef COUNTER_RANDOMNESS
+	#define COUNTER_RANDOMNESS 0
+#endif
+
+// rings of at least STREAMING_RING_SIZE members are committed to with a streaming treehash,
+// which keeps logN nodes per thread instead of the expansion buffer and all the commitments.
+// the randomness and the dummy commitments are the same as in memory, so the roots do not change
+#ifndef STREAMING_RING_SIZE
+	#define STREAMING_RING_SIZE (1 << 16)
+#endif
+#define EXECUTION_BUF_LEN(rings) ((COUNTER_RANDOMNESS || ring_streaming(rings)) ? 0 : SEED_BYTES*((rings)+2))
+#define EXECUTION_COMMITMENTS_LEN(rings) (ring_streaming(rings) ? HASH_BYTES : HASH_BYTES*RING_TREE_NODES(rings))
+
+// alignment of the regions in a workspace, a workspace itself may have any alignment
+#define WORKSPACE_ALIGN 32
+
 extern uint64_t restarts;
 
-#define RSIG_SALT(sig) (sig)
+// the first byte of a signature (after the tag of a linkable one) records the format variant it was made with,
+// signatures of another variant are refused with VERIFY_FORMAT_MISMATCH before any other work
+#define SIG_FORMAT (HASH_SUITE | (UNPADDED_TREE << 1) | (COUNTER_RANDOMNESS << 2))
+#define VERIFY_FORMAT_MISMATCH -3
+
+#define RSIG_FORMAT(sig) (sig)
+#define RSIG_SALT(sig) (RSIG_FORMAT(sig) + 1)
 #define RSIG_CHALLENGE(sig) (RSIG_SALT(sig) + HASH_BYTES)
 #define RSIG_Z(sig) (RSIG_CHALLENGE(sig) + SEED_BYTES)
 #define RSIG_COMMITMENT_RANDOMNESS(sig) (RSIG_Z(sig) + S3_BYTES*ZEROS)
@@ -19,18 +71,152 @@ extern uint64_t restarts;
 #define RSIG_SEEDS(sig, logN) (RSIG_PATHS(sig) + logN*HASH_BYTES*ZEROS )
 #define RSIG_BYTES(logN) (RSIG_SEEDS(0,logN) + SEED_BYTES*ONES)
 
+// incremental hash of a message, for signing and verifying messages that are not contiguous in memory
+typedef struct {
+	HASH_CTX state;
+} message_hash_ctx;
+
+// a ring whose public keys are validated and copied to aligned memory once, to be reused for many calls.
+// the sizes that only depend on the number of members are computed once as well
+typedef struct {
+	int64_t rings;
+	int logN;
+	// leaves and nodes of the padded Merkle tree
+	int64_t leaves;
+	int64_t nodes;
+	int streaming;
+	// the randomness of the members and the dummy nodes is derived by index instead of expanded
+	int counter;
+	// per-thread expansion buffer and commitments of an execution
+	uint64_t buf_len;
+	uint64_t commitments_len;
+	unsigned char digest[HASH_BYTES];
+	const unsigned char *pks;
+	unsigned char *allocated;
+} ring_ctx;
+
+// state of a signature whose commitments are computed before the message is known, it can be finished only once.
+// a linkable signature also keeps its tag, so a presignature needs the alignment of public_key
+typedef struct {
+	unsigned char sk[SK_BYTES];
+	int64_t I;
+	ring_ctx ring;
+	int threads;
+	int used;
+	int low_memory;
+	int linkable;
+	parallel_control *control;
+	public_key tag;
+	unsigned char salt[HASH_BYTES];
+	GRPELTS2 *r;
+	int r_count;
+	unsigned char *seed_tree;
+	unsigned char *commitment_randomness;
+	unsigned char *transcript;
+	unsigned char *paths;
+	unsigned char *bufs;
+	unsigned char *commitments;
+	unsigned char *allocated;
+} rsign_presig;
+
+// limits of rverify_bounded, 0 means no limit
+typedef struct {
+	// cycles spent on the executions, summed over all the threads
+	uint64_t cycles;
+	// CLOCK_MONOTONIC time in nanoseconds
+	uint64_t deadline_ns;
+} verify_budget;
+
+// returned by rverify_bounded and lrverify_bounded once the budget is used up
+#define VERIFY_BUDGET_EXCEEDED -2
+
+// an unopened execution whose root is recomputed by commit_to_ring_tile
+typedef struct {
+	const unsigned char *seed;
+	int i;
+	const unsigned char *salt;
+	unsigned char *root;
+} ring_commitment;
+
 void keygen(unsigned char *pk, unsigned char *sk);
+void message_hash_init(message_hash_ctx *ctx);
+void message_hash_update(message_hash_ctx *ctx, const unsigned char *m, uint64_t mlen);
+void message_hash_final(message_hash_ctx *ctx, unsigned char *message_hash);
+int ring_ctx_init(ring_ctx *ring, const unsigned char *pks, const int64_t ring_size);
+void ring_ctx_clear(ring_ctx *ring);
+// fills in the sizes of a ring of caller-owned keys without copying or validating them,
+// the ring is left empty and -1 is returned if ring_size is out of range
+int ring_ctx_view(ring_ctx *ring, const unsigned char *pks, const int64_t ring_size);
 int rsign(const unsigned char *sk_I, const int64_t I, const unsigned char *pks, const int64_t ring_size, const unsigned char *m, uint64_t mlen, unsigned char *sig, uint64_t *sig_len);
+int rsign_mt(const unsigned char *sk_I, const int64_t I, const unsigned char *pks, const int64_t ring_size, const unsigned char *m, uint64_t mlen, unsigned char *sig, uint64_t *sig_len, int threads);
+int rsign_ws(const unsigned char *sk_I, const int64_t I, const unsigned char *pks, const int64_t ring_size, const unsigned char *m, uint64_t mlen, unsigned char *sig, uint64_t *sig_len, int threads, unsigned char *workspace);
+int rsign_lowmem(const unsigned char *sk_I, const int64_t I, const unsigned char *pks, const int64_t ring_size, const unsigned char *m, uint64_t mlen, unsigned char *sig, uint64_t *sig_len, int threads, unsigned char *workspace);
+int rsign_speculative(const unsigned char *sk_I, const int64_t I, const unsigned char *pks, const int64_t ring_size, const unsigned char *m, uint64_t mlen, unsigned char *sig, uint64_t *sig_len, int threads, int candidates);
+int rsign_prehashed(const unsigned char *sk_I, const int64_t I, const unsigned char *pks, const int64_t ring_size, const unsigned char *message_hash, unsigned char *sig, uint64_t *sig_len, int threads, unsigned char *workspace);
+int rsign_controlled(const unsigned char *sk_I, const int64_t I, const unsigned char *pks, const int64_t ring_size, const unsigned char *message_hash, unsigned char *sig, uint64_t *sig_len, int threads, parallel_control *control);
+int rsign_ctx(const unsigned char *sk_I, const int64_t I, const ring_ctx *ring, const unsigned char *m, uint64_t mlen, unsigned char *sig, uint64_t *sig_len, int threads, unsigned char *workspace);
+int rsign_presign(rsign_presig *presig, const unsigned char *sk_I, const int64_t I, const unsigned char *pks, const int64_t ring_size, int threads, unsigned char *workspace);
+int rsign_presign_lowmem(rsign_presig *presig, const unsigned char *sk_I, const int64_t I, const unsigned char *pks, const int64_t ring_size, int threads, unsigned char *workspace);
+int rsign_finish(rsign_presig *presig, const unsigned char *m, uint64_t mlen, unsigned char *sig, uint64_t *sig_len);
+int rsign_finish_prehashed(rsign_presig *presig, const unsigned char *message_hash, unsigned char *sig, uint64_t *sig_len);
+void rsign_presig_clear(rsign_presig *presig);
 int  rverify(const unsigned char *pks, const int64_t ring_size, const unsigned char *m, uint64_t mlen, const unsigned char *sig);
+int  rverify_mt(const unsigned char *pks, const int64_t ring_size, const unsigned char *m, uint64_t mlen, const unsigned char *sig, int threads);
+int  rverify_ws(const unsigned char *pks, const int64_t ring_size, const unsigned char *m, uint64_t mlen, const unsigned char *sig, int threads, unsigned char *workspace);
+int  rverify_prehashed(const unsigned char *pks, const int64_t ring_size, const unsigned char *message_hash, const unsigned char *sig, int threads, unsigned char *workspace);
+int  rverify_controlled(const unsigned char *pks, const int64_t ring_size, const unsigned char *message_hash, const unsigned char *sig, int threads, parallel_control *control);
+int  rverify_ctx(const ring_ctx *ring, const unsigned char *m, uint64_t mlen, const unsigned char *sig, int threads, unsigned char *workspace);
+int  rverify_batch(const unsigned char *pks, const int64_t ring_size, const unsigned char *const *ms, const uint64_t *mlens, const unsigned char *const *sigs, int count, int *results, int threads);
+// checks the signature length and all the responses before any action on the ring is computed
+int  rverify_bounded(const unsigned char *pks, const int64_t ring_size, const unsigned char *m, uint64_t mlen, const unsigned char *sig, uint64_t sig_len, int threads, const verify_budget *budget);
+int  rverify_bounded_prehashed(const unsigned char *pks, const int64_t ring_size, const unsigned char *message_hash, const unsigned char *sig, uint64_t sig_len, int threads, const verify_budget *budget);
+
+// size of the workspace that rsign_ws/rsign_presign and rverify_ws need for a ring of ring_size members
+uint64_t rsign_workspace_size(const int64_t ring_size, int threads);
+// the same for rsign_lowmem/rsign_presign_lowmem, which only keep r_i and the paths of the opened executions
+uint64_t rsign_lowmem_workspace_size(const int64_t ring_size, int threads);
+uint64_t rverify_workspace_size(const int64_t ring_size, int threads);
+
+// shared by rsign and lrsign, a linkable signature is the tag followed by a signature with the layout of RSIG_*
+uint64_t sign_workspace_size(const int64_t ring_size, int threads, int low_memory, int linkable);
+uint64_t verify_workspace_size(const int64_t ring_size, int threads, int linkable);
+int sign_presign_mode(rsign_presig *presig, const unsigned char *sk_I, const int64_t I, const ring_ctx *ring, int threads, unsigned char *workspace, int low_memory, int linkable, parallel_control *control);
+int sign_speculative(const unsigned char *sk_I, const int64_t I, const ring_ctx *ring, const unsigned char *m, uint64_t mlen, unsigned char *sig, uint64_t *sig_len, int threads, int candidates, int linkable);
+int verify_run(const ring_ctx *ring, const unsigned char *message_hash, const unsigned char *sig, int threads, unsigned char *workspace, parallel_control *control, const verify_budget *budget, int linkable);
+int verify_bounded_prehashed(const ring_ctx *ring, const unsigned char *message_hash, const unsigned char *sig, uint64_t sig_len, int threads, const verify_budget *budget, int linkable);
+int verify_batch(const ring_ctx *ring, const unsigned char *const *ms, const uint64_t *mlens, const unsigned char *const *sigs, int count, int *results, int threads, int linkable);
 
 #ifdef BG
 	int bg_check(XELT *X);
 #endif
 
+// length of the hashed input of a commitment
+#ifdef BG
+	#define COMMIT_INPUT_BYTES (512 + SEED_BYTES)
+#else
+	#define COMMIT_INPUT_BYTES (sizeof(XELT) + SEED_BYTES)
+#endif
+
 void commit(const XELT *R, const unsigned char *randomness, const unsigned char *salt, unsigned char *commitment);
-void build_tree_and_path(const unsigned char *commitments_in, int logN, int64_t I, unsigned char * root, unsigned char *path);
+// the same commitments as commit, COMMIT_LANES at a time with the parallel Keccak permutations
+void commit_batch(const XELT *R, const unsigned char *const *randomness, const unsigned char *salt, unsigned char *const *commitments, int count);
+// control may be NULL, otherwise the members stop once it is cancelled (leaving the root unfinished) and charge their cycles to it
+void commit_to_ring(const unsigned char *seed, int i, const ring_ctx *ring, const int64_t I, const unsigned char *salt, GRPELTS2 *r, unsigned char *buf, unsigned char *commitments, unsigned char *commitment_randomness, unsigned char *root, unsigned char *path, int threads, parallel_control *control);
+// the root and path of commit_to_ring, without buffers that grow with the ring size
+void commit_to_ring_streaming(const unsigned char *seed, int i, const ring_ctx *ring, const int64_t I, const unsigned char *salt, GRPELTS2 *r, unsigned char *commitment_randomness, unsigned char *root, unsigned char *path, int threads, parallel_control *control);
+void commit_to_ring_tile(const ring_commitment *tile, int count, const ring_ctx *ring, GRPELTS2 *r, unsigned char *bufs, unsigned char *commitments);
+void build_tree_and_path(unsigned char *commitments, int logN, int64_t I, unsigned char * root, unsigned char *path);
+void build_unbalanced_tree_and_path(unsigned char *commitments, int64_t leaves, int64_t I, unsigned char * root, unsigned char *path);
 void reconstruct_root(const unsigned char *data, const unsigned char *path, int logN, unsigned char *root);
 void derive_challenge(const unsigned char *challenge_seed, unsigned char *challenge);
 int log_round_up(int64_t a);
+int ring_streaming(int64_t ring_size);
+int ring_member_threads(int64_t ring_size, int threads);
+int execution_threads(int64_t ring_size, int threads, int *member_threads);
+uint64_t workspace_take(uint64_t *size, uint64_t bytes);
+unsigned char *workspace_align(unsigned char *workspace);
+uint64_t monotonic_ns(void);
+uint64_t cpu_cycles(void);
+int verify_budget_exceeded(const verify_budget *budget, uint64_t cycles);
 
 #endif
@@ -1,4 +1,5 @@
 #include "seedtree.h"
+#include "hash_lanes.h"
 #include <openssl/rand.h>
 
 #define LEFT_CHILD(i) (2*i+1)
@@ -7,16 +8,48 @@
 #define SIBLING(i) (((i)%2)? i+1 : i-1 )
 #define IS_LEFT_SIBLING(i) (i%2)
 
+// expands count nodes of the same level into their children, HASH_LANES nodes per permutation call
+static void expand_nodes(unsigned char *tree, const uint32_t *nodes, int count, const unsigned char *salt){
+	unsigned char buf[HASH_LANES][HASH_BYTES + SEED_BYTES + sizeof(uint32_t)];
+	const unsigned char *in[HASH_LANES];
+	unsigned char *out[HASH_LANES];
+
+	for (int k = 0; k < count; k += HASH_LANES)
+	{
+		int lanes = (count - k < HASH_LANES) ? count - k : HASH_LANES;
+		for (int lane = 0; lane < lanes; ++lane)
+		{
+			uint32_t i = nodes[k + lane];
+			memcpy(buf[lane], salt, HASH_BYTES);
+			memcpy(buf[lane] + HASH_BYTES, tree + i*SEED_BYTES, SEED_BYTES);
+			memcpy(buf[lane] + HASH_BYTES + SEED_BYTES, &i, sizeof(uint32_t));
+			in[lane] = buf[lane];
+			out[lane] = tree + LEFT_CHILD(i)*SEED_BYTES;
+		}
+
+		// both children are one HASH_BYTES output
+		if (lanes == 1){
+			EXPAND(in[0], sizeof(buf[0]), out[0], 2*SEED_BYTES);
+		}
+		else{
+			hash_lanes(in, sizeof(buf[0]), out, lanes);
+		}
+	}
+}
+
+// the nodes of a level only depend on the level above, so a level is expanded at once
 void generate_seed_tree(unsigned char *seed_tree, uint64_t leaves, const unsigned char *salt){
-	unsigned char buf[sizeof(uint32_t) + HASH_BYTES + SEED_BYTES];
-	memcpy(buf,salt,HASH_BYTES);
-	uint32_t *pos = (uint32_t *) (buf + HASH_BYTES + SEED_BYTES);
+	uint32_t nodes[leaves];
 
 	RAND_bytes(seed_tree,SEED_BYTES);
-	for(uint32_t i=0; i<leaves-1; i++){
-		memcpy(buf + HASH_BYTES, seed_tree + i*SEED_BYTES, SEED_BYTES);
-		*pos = i;
-		EXPAND(buf,HASH_BYTES + SEED_BYTES + sizeof(uint32_t),seed_tree + LEFT_CHILD(i)*SEED_BYTES, 2*SEED_BYTES);
+	for (uint64_t first = 0; first < leaves-1; first = LEFT_CHILD(first))
+	{
+		uint64_t end = (LEFT_CHILD(first) < leaves-1) ? LEFT_CHILD(first) : leaves-1;
+		for (uint64_t i = first; i < end; ++i)
+		{
+			nodes[i - first] = i;
+		}
+		expand_nodes(seed_tree, nodes, end - first, salt);
 	}
 }
 
@@ -58,28 +91,42 @@ void release_seeds(unsigned char *tree, uint64_t leaves, const unsigned char *in
 	}
 }
 
-void fill_down(unsigned char *tree, uint64_t leaves, const unsigned char *indices, const unsigned char *in, uint64_t *nodes_used, const unsigned char *salt){
+uint64_t count_released_seeds(uint64_t leaves, const unsigned char *indices){
 	unsigned char class_tree[2*leaves-1];
 	fill_tree(indices,class_tree,leaves);
 
-	unsigned char buf[HASH_BYTES+SEED_BYTES + sizeof(uint32_t)];
-	memcpy(buf, salt, HASH_BYTES);
-	uint32_t *pos = (uint32_t *) (buf + HASH_BYTES + SEED_BYTES);
+	uint64_t seeds_released = 0;
+	for(uint64_t i=0; i< 2*leaves-1; i++){
+		seeds_released += (class_tree[i] == 0) && (class_tree[PARENT(i)] == 1);
+	}
+	return seeds_released;
+}
 
-	int i;
+void fill_down(unsigned char *tree, uint64_t leaves, const unsigned char *indices, const unsigned char *in, uint64_t *nodes_used, const unsigned char *salt){
+	unsigned char class_tree[2*leaves-1];
+	fill_tree(indices,class_tree,leaves);
+
+	// the released seeds are in index order
 	(*nodes_used) = 0;
-	for(i=0; i<2*leaves-1; i++){
-		if(class_tree[i] == 0){
-			if(class_tree[PARENT(i)] == 1){
-				memcpy(tree + SEED_BYTES*i, in + SEED_BYTES*(*nodes_used), SEED_BYTES);
-				(*nodes_used)++;
-			}
-			if(i<leaves-1){
-				memcpy(buf + HASH_BYTES, tree + SEED_BYTES*i, SEED_BYTES);
-				*pos = i;
-				EXPAND(buf, HASH_BYTES + SEED_BYTES + sizeof(uint32_t),tree + SEED_BYTES*LEFT_CHILD(i), 2*SEED_BYTES);
-			}
+	for(int i=0; i<2*leaves-1; i++){
+		if((class_tree[i] == 0) && (class_tree[PARENT(i)] == 1)){
+			memcpy(tree + SEED_BYTES*i, in + SEED_BYTES*(*nodes_used), SEED_BYTES);
+			(*nodes_used)++;
+		}
+	}
+
+	// only the nodes below a released seed are expanded, a level at a time
+	uint32_t nodes[leaves];
+	for (uint64_t first = 0; first < leaves-1; first = LEFT_CHILD(first))
+	{
+		uint64_t end = (LEFT_CHILD(first) < leaves-1) ? LEFT_CHILD(first) : leaves-1;
+		int count = 0;
+		for (uint64_t i = first; i < end; ++i)
+		{
+			if (class_tree[i] == 0)
+				nodes[count++] = i;
 		}
+		expand_nodes(tree, nodes, count, salt);
 	}
 }
 
@@ -9,6 +9,8 @@
 
 void generate_seed_tree(unsigned char *seed_tree, uint64_t leaves, const unsigned char *salt);
 void release_seeds(unsigned char *tree, uint64_t leaves, const unsigned char *indices, unsigned char *out, uint64_t *seeds_released );
+// number of seeds release_seeds outputs for these indices
+uint64_t count_released_seeds(uint64_t leaves, const unsigned char *indices);
 void fill_down(unsigned char *tree, uint64_t leaves, const unsigned char *indices, const unsigned char *in, uint64_t *nodes_used, const unsigned char *salt);
 
 void print_seed(const unsigned char *seed);
@@ -1,6 +1,14 @@
+// the tests swap in a deterministic RAND_bytes through RAND_set_rand_method
+#define OPENSSL_SUPPRESS_DEPRECATED
+
 #include "rsign.h"
 #include "lrsign.h"
+#include "async.h"
+#include "verify_cache.h"
+#include "seedtree.h"
 #include "parameters.h"
+#include "keccak_dispatch.h"
+#include <openssl/rand.h>
 #include <stdio.h>
 #include <time.h>
 #include "stdlib.h"
@@ -9,16 +17,46 @@
 #define SIGNINGS 1
 #define MESSAGE_BYTES 500
 
+#ifndef THREADS
+	#define THREADS 1
+#endif
+
+#ifndef CANDIDATES
+	#define CANDIDATES 1
+#endif
+
+// RS(sign_presig) is rsign_presig, or lrsign_presig for the linkable signatures
 #ifdef TEST_LINKABLE
 	#define sign lrsign
 	#define verify lrverify
 	#define SIG_BYTES LRSIG_BYTES
+	#define SIG_SEEDS LRSIG_SEEDS
+	#define SIG_FORMAT_BYTE LRSIG_FORMAT
+	#define LINKABLE 1
+	#define RS(name) lr##name
+	#define async_sign async_lrsign
+	#define async_verify async_lrverify
 #else
  	#define sign rsign
 	#define verify rverify
 	#define SIG_BYTES RSIG_BYTES
+	#define SIG_SEEDS RSIG_SEEDS
+	#define SIG_FORMAT_BYTE RSIG_FORMAT
+	#define LINKABLE 0
+	#define RS(name) r##name
+	#define async_sign async_rsign
+	#define async_verify async_rverify
 #endif
 
+// the behavior tests run before the benchmark on a ring of TEST_RING members. with the isogeny action they take
+// hours on one core, -DBEHAVIOR_TESTS=0 skips them
+#ifndef BEHAVIOR_TESTS
+	#define BEHAVIOR_TESTS 1
+#endif
+
+#define TEST_RING 5
+#define TEST_LOG_N 3
+
 #define LOG_N LOG(KEYGENS)
 
 static inline
@@ -34,6 +72,947 @@ extern uint64_t restarts;
 
 #define PS(x) ((x > Q/2)? ((int)x-Q):((int) x))
 
+static int failures = 0;
+
+#define CHECK(c) if (!(c)) { printf("check failed, line %d: %s \n", __LINE__, #c); failures++; }
+
+// RAND_bytes as a counter: every call gets the hash of the next value, so two signings that start from the same
+// value draw the same salt and seeds
+static atomic_uint_fast64_t rand_counter;
+static const RAND_METHOD *system_rand;
+
+static int counter_bytes(unsigned char *buf, int num){
+	uint64_t counter = atomic_fetch_add(&rand_counter, 1);
+	SHAKE128(buf, num, (unsigned char *) &counter, sizeof(counter));
+	return 1;
+}
+
+static int counter_status(void){
+	return 1;
+}
+
+static RAND_METHOD counter_rand = {NULL, counter_bytes, NULL, NULL, counter_bytes, counter_status};
+
+static void rand_from_counter(uint64_t start){
+	if (system_rand == NULL)
+		system_rand = RAND_get_rand_method();
+	atomic_store(&rand_counter, start);
+	RAND_set_rand_method(&counter_rand);
+}
+
+static void rand_from_system(void){
+	RAND_set_rand_method(system_rand);
+}
+
+// signing on more threads, with the executions spread over the work-stealing pool, gives the bytes of the
+// serial signature, and so does the low-memory signer
+static void test_sign_threads(const unsigned char *pks, const unsigned char *sks, const unsigned char *message){
+	unsigned char *sig = aligned_alloc(32, SIG_BYTES(TEST_LOG_N));
+	unsigned char *threaded = aligned_alloc(32, SIG_BYTES(TEST_LOG_N));
+	uint64_t sig_len, threaded_len;
+
+	rand_from_counter(0);
+	CHECK(RS(sign)(sks + SK_BYTES, 1, pks, TEST_RING, message, MESSAGE_BYTES, sig, &sig_len) == 0);
+	for (int threads = 2; threads <= 8; threads *= 2)
+	{
+		rand_from_counter(0);
+		CHECK(RS(sign_mt)(sks + SK_BYTES, 1, pks, TEST_RING, message, MESSAGE_BYTES, threaded, &threaded_len, threads) == 0);
+		CHECK(threaded_len == sig_len && memcmp(sig, threaded, sig_len) == 0);
+
+		rand_from_counter(0);
+		CHECK(RS(sign_lowmem)(sks + SK_BYTES, 1, pks, TEST_RING, message, MESSAGE_BYTES, threaded, &threaded_len, threads, NULL) == 0);
+		CHECK(threaded_len == sig_len && memcmp(sig, threaded, sig_len) == 0);
+	}
+	rand_from_system();
+
+	CHECK(RS(verify)(pks, TEST_RING, message, MESSAGE_BYTES, sig) == 0);
+
+	free(sig);
+	free(threaded);
+}
+
+// on one thread the candidates of a speculative signing are built in order, so when the first transcript is accepted
+// the speculative signature is the serial one from the same randomness, for any number of candidates. on more
+// threads the candidates draw their randomness in any order, their signatures verify like any other
+#define TEST_SPECULATIVE_TRIES 8
+
+static void test_speculative(const unsigned char *pks, const unsigned char *sks, const unsigned char *message){
+	unsigned char *sig = aligned_alloc(32, SIG_BYTES(TEST_LOG_N));
+	unsigned char *speculative = aligned_alloc(32, SIG_BYTES(TEST_LOG_N));
+	uint64_t sig_len, speculative_len;
+	int compared = 0;
+
+	for (int try = 0; try < TEST_SPECULATIVE_TRIES && !compared; ++try)
+	{
+		uint64_t restarted = restarts;
+		rand_from_counter(100*try);
+		CHECK(RS(sign)(sks + 3*SK_BYTES, 3, pks, TEST_RING, message, MESSAGE_BYTES, sig, &sig_len) == 0);
+		if (restarts != restarted)
+			continue;
+
+		for (int candidates = 1; candidates <= 3; ++candidates)
+		{
+			rand_from_counter(100*try);
+			CHECK(RS(sign_speculative)(sks + 3*SK_BYTES, 3, pks, TEST_RING, message, MESSAGE_BYTES, speculative, &speculative_len, 1, candidates) == 0);
+			CHECK(speculative_len == sig_len && memcmp(sig, speculative, sig_len) == 0);
+		}
+		compared = 1;
+	}
+	rand_from_system();
+	CHECK(compared);
+
+	for (int candidates = 2; candidates <= 3; ++candidates)
+	{
+		CHECK(RS(sign_speculative)(sks + 3*SK_BYTES, 3, pks, TEST_RING, message, MESSAGE_BYTES, speculative, &speculative_len, 4, candidates) == 0);
+		CHECK(speculative_len <= SIG_BYTES(TEST_LOG_N) && *SIG_FORMAT_BYTE(speculative) == SIG_FORMAT);
+		CHECK(RS(verify)(pks, TEST_RING, message, MESSAGE_BYTES, speculative) == 0);
+		CHECK(RS(verify)(pks, TEST_RING, message, MESSAGE_BYTES - 1, speculative) != 0);
+	}
+
+	free(sig);
+	free(speculative);
+}
+
+// verifying on more threads accepts the signatures the serial verifier accepts, and rejects them with the same result
+// when any part after the tag is changed. the lattice tag only enters the commitments rounded, so a change of its
+// low bits may still verify
+#define TEST_TAMPERS 4
+
+static void test_verify_threads(const unsigned char *pks, const unsigned char *sks, const unsigned char *message){
+	unsigned char *sig = aligned_alloc(32, SIG_BYTES(TEST_LOG_N));
+	uint64_t sig_len;
+
+	CHECK(RS(sign_mt)(sks + 2*SK_BYTES, 2, pks, TEST_RING, message, MESSAGE_BYTES, sig, &sig_len, THREADS) == 0);
+	CHECK(RS(verify)(pks, TEST_RING, message, MESSAGE_BYTES, sig) == 0);
+	for (int threads = 2; threads <= 8; threads *= 2)
+	{
+		CHECK(RS(verify_mt)(pks, TEST_RING, message, MESSAGE_BYTES, sig, threads) == 0);
+	}
+
+	uint64_t body = SIG_FORMAT_BYTE(sig) - sig;
+	for (int k = 0; k <= TEST_TAMPERS; ++k)
+	{
+		uint64_t offset = (k < TEST_TAMPERS) ? body + k*(sig_len - body)/TEST_TAMPERS : sig_len - 1;
+		sig[offset] ^= 1;
+		int serial = RS(verify)(pks, TEST_RING, message, MESSAGE_BYTES, sig);
+		CHECK(serial != 0);
+		CHECK(RS(verify_mt)(pks, TEST_RING, message, MESSAGE_BYTES, sig, 4) == serial);
+		sig[offset] ^= 1;
+	}
+
+	free(sig);
+}
+
+// a presignature signs a single message, finishing it again is refused and leaves the signature alone
+static void test_presign_once(const unsigned char *pks, const unsigned char *sks, const unsigned char *message){
+	unsigned char *sig = aligned_alloc(32, SIG_BYTES(TEST_LOG_N));
+	unsigned char *again = aligned_alloc(32, SIG_BYTES(TEST_LOG_N));
+	uint64_t sig_len, again_len = 0;
+	RS(sign_presig) presig;
+
+	CHECK(RS(sign_presign)(&presig, sks + 2*SK_BYTES, 2, pks, TEST_RING, THREADS, NULL) == 0);
+	CHECK(RS(sign_finish)(&presig, message, MESSAGE_BYTES, sig, &sig_len) == 0);
+	CHECK(RS(verify_mt)(pks, TEST_RING, message, MESSAGE_BYTES, sig, THREADS) == 0);
+
+	memset(again, 0, SIG_BYTES(TEST_LOG_N));
+	CHECK(RS(sign_finish)(&presig, message, MESSAGE_BYTES - 1, again, &again_len) == -1);
+	CHECK(RS(sign_finish_prehashed)(&presig, message, again, &again_len) == -1);
+	CHECK(again_len == 0 && again[0] == 0 && again[sig_len - 1] == 0);
+
+	// a cleared presignature that was never finished is refused as well
+	CHECK(RS(sign_presign)(&presig, sks, 0, pks, TEST_RING, THREADS, NULL) == 0);
+	RS(sign_presig_clear)(&presig);
+	CHECK(RS(sign_finish)(&presig, message, MESSAGE_BYTES, again, &again_len) == -1);
+
+	free(sig);
+	free(again);
+}
+
+// signing and verifying in a caller workspace, which may have any alignment, gives the same results as with
+// a workspace that is allocated internally
+static void test_workspace(const unsigned char *pks, const unsigned char *sks, const unsigned char *message){
+	unsigned char *sig = aligned_alloc(32, SIG_BYTES(TEST_LOG_N));
+	unsigned char *ws_sig = aligned_alloc(32, SIG_BYTES(TEST_LOG_N));
+	uint64_t sig_len, ws_sig_len;
+	uint64_t size = RS(sign_workspace_size)(TEST_RING, THREADS);
+	if (RS(verify_workspace_size)(TEST_RING, THREADS) > size)
+		size = RS(verify_workspace_size)(TEST_RING, THREADS);
+	unsigned char *workspace = malloc(size + 1);
+
+	CHECK(RS(sign_ws)(sks + SK_BYTES, 1, pks, TEST_RING, message, MESSAGE_BYTES, sig, &sig_len, THREADS, NULL) == 0);
+	CHECK(RS(sign_ws)(sks + SK_BYTES, 1, pks, TEST_RING, message, MESSAGE_BYTES, ws_sig, &ws_sig_len, THREADS, workspace + 1) == 0);
+	CHECK(sig_len <= SIG_BYTES(TEST_LOG_N) && ws_sig_len <= SIG_BYTES(TEST_LOG_N));
+
+	CHECK(RS(verify_ws)(pks, TEST_RING, message, MESSAGE_BYTES, sig, THREADS, workspace + 1) == 0);
+	CHECK(RS(verify_ws)(pks, TEST_RING, message, MESSAGE_BYTES, ws_sig, THREADS, NULL) == 0);
+	CHECK(RS(verify_ws)(pks, TEST_RING, message, MESSAGE_BYTES, ws_sig, THREADS, workspace) == 0);
+
+	// a signature for another message is rejected either way
+	CHECK(RS(verify_ws)(pks, TEST_RING, message, MESSAGE_BYTES - 1, ws_sig, THREADS, NULL) != 0);
+	CHECK(RS(verify_ws)(pks, TEST_RING, message, MESSAGE_BYTES - 1, ws_sig, THREADS, workspace + 1) != 0);
+
+	free(sig);
+	free(ws_sig);
+	free(workspace);
+}
+
+// the low-memory signer needs a smaller workspace, and its signatures verify like any other
+static void test_lowmem(const unsigned char *pks, const unsigned char *sks, const unsigned char *message){
+	unsigned char *sig = aligned_alloc(32, SIG_BYTES(TEST_LOG_N));
+	uint64_t sig_len;
+	RS(sign_presig) presig;
+	uint64_t size = RS(sign_lowmem_workspace_size)(TEST_RING, THREADS);
+	unsigned char *workspace = malloc(size);
+
+	CHECK(size < RS(sign_workspace_size)(TEST_RING, THREADS));
+
+	for (int i = 0; i < TEST_RING; ++i)
+	{
+		CHECK(RS(sign_lowmem)(sks + i*SK_BYTES, i, pks, TEST_RING, message, MESSAGE_BYTES, sig, &sig_len, THREADS, (i % 2) ? workspace : NULL) == 0);
+		CHECK(RS(verify_mt)(pks, TEST_RING, message, MESSAGE_BYTES, sig, THREADS) == 0);
+	}
+	CHECK(RS(verify_mt)(pks, TEST_RING, message, MESSAGE_BYTES - 1, sig, THREADS) != 0);
+
+	CHECK(RS(sign_presign_lowmem)(&presig, sks + 3*SK_BYTES, 3, pks, TEST_RING, THREADS, workspace) == 0);
+	CHECK(RS(sign_finish)(&presig, message, MESSAGE_BYTES, sig, &sig_len) == 0);
+	CHECK(RS(verify_mt)(pks, TEST_RING, message, MESSAGE_BYTES, sig, THREADS) == 0);
+
+	free(sig);
+	free(workspace);
+}
+
+// a batch reports every signature on its own, a single corrupted signature fails the batch and only its own result
+#define TEST_BATCH 6
+
+static void test_batch(const unsigned char *pks, const unsigned char *sks){
+	unsigned char *sigs[TEST_BATCH];
+	unsigned char messages[TEST_BATCH][MESSAGE_BYTES];
+	const unsigned char *ms[TEST_BATCH];
+	uint64_t mlens[TEST_BATCH];
+	int results[TEST_BATCH];
+	uint64_t sig_len;
+
+	for (int b = 0; b < TEST_BATCH; ++b)
+	{
+		sigs[b] = aligned_alloc(32, SIG_BYTES(TEST_LOG_N));
+		memset(messages[b], b, MESSAGE_BYTES);
+		ms[b] = messages[b];
+		mlens[b] = MESSAGE_BYTES - b;
+		CHECK(RS(sign_mt)(sks + (b % TEST_RING)*SK_BYTES, b % TEST_RING, pks, TEST_RING, ms[b], mlens[b], sigs[b], &sig_len, THREADS) == 0);
+	}
+
+	CHECK(RS(verify_batch)(pks, TEST_RING, ms, mlens, (const unsigned char *const *) sigs, TEST_BATCH, results, THREADS) == 0);
+	for (int b = 0; b < TEST_BATCH; ++b)
+	{
+		CHECK(results[b] == 0);
+	}
+
+	// a seed of the seed tree, from which the verifier recomputes the executions with challenge bit 1
+	SIG_SEEDS(sigs[4], TEST_LOG_N)[0] ^= 1;
+	CHECK(RS(verify_batch)(pks, TEST_RING, ms, mlens, (const unsigned char *const *) sigs, TEST_BATCH, results, THREADS) == -1);
+	for (int b = 0; b < TEST_BATCH; ++b)
+	{
+		CHECK(results[b] == ((b == 4) ? -1 : 0));
+	}
+	CHECK(RS(verify_mt)(pks, TEST_RING, ms[4], mlens[4], sigs[4], THREADS) != 0);
+
+	for (int b = 0; b < TEST_BATCH; ++b)
+	{
+		free(sigs[b]);
+	}
+}
+
+// a ring context validates its keys once, a ring with an invalid key is rejected
+static void invalidate_pk(public_key *X){
+#ifdef LATTICE
+	(*X).vec[1].coeffs[7] = Q;
+#else
+	// a curve next to a supersingular one is almost surely not supersingular
+	((unsigned char *) X)[0] ^= 1;
+#endif
+}
+
+static void test_ring_ctx(const unsigned char *pks, const unsigned char *sks, const unsigned char *message){
+	unsigned char *sig = aligned_alloc(32, SIG_BYTES(TEST_LOG_N));
+	unsigned char *bad = aligned_alloc(32, TEST_RING*PK_BYTES);
+	uint64_t sig_len;
+	ring_ctx ring;
+
+	CHECK(ring_ctx_init(&ring, pks, TEST_RING) == 0);
+	CHECK(ring.rings == TEST_RING && ring.logN == TEST_LOG_N);
+	CHECK(RS(sign_ctx)(sks + 4*SK_BYTES, 4, &ring, message, MESSAGE_BYTES, sig, &sig_len, THREADS, NULL) == 0);
+	CHECK(RS(verify_ctx)(&ring, message, MESSAGE_BYTES, sig, THREADS, NULL) == 0);
+	CHECK(RS(verify_mt)(pks, TEST_RING, message, MESSAGE_BYTES, sig, THREADS) == 0);
+	CHECK(RS(verify_ctx)(&ring, message, MESSAGE_BYTES - 1, sig, THREADS, NULL) != 0);
+	ring_ctx_clear(&ring);
+
+	memcpy(bad, pks, TEST_RING*PK_BYTES);
+	invalidate_pk((public_key *) (bad + 3*PK_BYTES));
+	CHECK(ring_ctx_init(&ring, bad, TEST_RING) == -1);
+	CHECK(ring.pks == NULL && ring.rings == 0);
+
+	// rings of an out of range size and signers outside the ring are refused as well
+	CHECK(ring_ctx_init(&ring, pks, 0) == -1);
+	CHECK(RS(sign_mt)(sks, 0, pks, 0, message, MESSAGE_BYTES, sig, &sig_len, THREADS) == -1);
+	CHECK(RS(sign_mt)(sks, TEST_RING, pks, TEST_RING, message, MESSAGE_BYTES, sig, &sig_len, THREADS) == -1);
+
+	free(sig);
+	free(bad);
+}
+
+// a message hashed in pieces gives the digest of HASH, and signing or verifying that digest is the same as
+// signing or verifying the message in one piece
+static void test_message_hash(const unsigned char *pks, const unsigned char *sks, const unsigned char *message){
+	unsigned char *sig = aligned_alloc(32, SIG_BYTES(TEST_LOG_N));
+	unsigned char digest[HASH_BYTES], streamed[HASH_BYTES];
+	uint64_t sig_len;
+	message_hash_ctx ctx;
+	RS(sign_presig) presig;
+
+	HASH(message, MESSAGE_BYTES, digest);
+	message_hash_init(&ctx);
+	message_hash_update(&ctx, message, 1);
+	message_hash_update(&ctx, message + 1, 0);
+	message_hash_update(&ctx, message + 1, 300);
+	message_hash_update(&ctx, message + 301, MESSAGE_BYTES - 301);
+	message_hash_final(&ctx, streamed);
+	CHECK(memcmp(digest, streamed, HASH_BYTES) == 0);
+
+	CHECK(RS(sign_prehashed)(sks, 0, pks, TEST_RING, streamed, sig, &sig_len, THREADS, NULL) == 0);
+	CHECK(RS(verify_mt)(pks, TEST_RING, message, MESSAGE_BYTES, sig, THREADS) == 0);
+
+	CHECK(RS(sign_mt)(sks + SK_BYTES, 1, pks, TEST_RING, message, MESSAGE_BYTES, sig, &sig_len, THREADS) == 0);
+	CHECK(RS(verify_prehashed)(pks, TEST_RING, streamed, sig, THREADS, NULL) == 0);
+
+	CHECK(RS(sign_presign)(&presig, sks + 2*SK_BYTES, 2, pks, TEST_RING, THREADS, NULL) == 0);
+	CHECK(RS(sign_finish_prehashed)(&presig, streamed, sig, &sig_len) == 0);
+	CHECK(RS(verify_mt)(pks, TEST_RING, message, MESSAGE_BYTES, sig, THREADS) == 0);
+
+	streamed[0] ^= 1;
+	CHECK(RS(verify_prehashed)(pks, TEST_RING, streamed, sig, THREADS, NULL) != 0);
+
+	free(sig);
+}
+
+// an async job reports its progress and calls back once, cancelled jobs that did not start never run
+#define TEST_JOBS 4
+
+static void count_callback(async_job *job, void *user){
+	atomic_fetch_add((atomic_int *) user, 1);
+}
+
+static void test_async(const unsigned char *pks, const unsigned char *sks, const unsigned char *message){
+	unsigned char *sigs[TEST_JOBS];
+	uint64_t sig_lens[TEST_JOBS];
+	async_job *jobs[TEST_JOBS];
+	atomic_int callbacks;
+	atomic_init(&callbacks, 0);
+	for (int j = 0; j < TEST_JOBS; ++j)
+	{
+		sigs[j] = aligned_alloc(32, SIG_BYTES(TEST_LOG_N));
+	}
+
+	// a single worker runs the jobs one after the other
+	async_executor *executor = async_executor_new(1, THREADS);
+
+	jobs[0] = async_sign(executor, sks, 0, pks, TEST_RING, message, MESSAGE_BYTES, sigs[0], &sig_lens[0], count_callback, &callbacks);
+	async_wait(jobs[0]);
+	CHECK(async_poll(jobs[0]) == ASYNC_DONE && async_result(jobs[0]) == 0);
+	CHECK(async_progress(jobs[0]) >= EXECUTIONS);
+	CHECK(atomic_load(&callbacks) == 1);
+
+	jobs[1] = async_verify(executor, pks, TEST_RING, message, MESSAGE_BYTES, sigs[0], count_callback, &callbacks);
+	async_wait(jobs[1]);
+	CHECK(async_poll(jobs[1]) == ASYNC_DONE && async_result(jobs[1]) == 0);
+	CHECK(async_progress(jobs[1]) > 0);
+	CHECK(atomic_load(&callbacks) == 2);
+	async_job_free(jobs[0]);
+	async_job_free(jobs[1]);
+
+	// the first job may already be done when it is cancelled, the others are still queued behind it
+	for (int j = 0; j < TEST_JOBS; ++j)
+	{
+		jobs[j] = async_sign(executor, sks + SK_BYTES, 1, pks, TEST_RING, message, MESSAGE_BYTES, sigs[j], &sig_lens[j], count_callback, &callbacks);
+	}
+	for (int j = TEST_JOBS - 1; j >= 0; --j)
+	{
+		async_cancel(jobs[j]);
+	}
+	for (int j = 0; j < TEST_JOBS; ++j)
+	{
+		async_wait(jobs[j]);
+		if (j == 0 && async_poll(jobs[j]) == ASYNC_DONE){
+			CHECK(async_result(jobs[j]) == 0);
+			CHECK(RS(verify_mt)(pks, TEST_RING, message, MESSAGE_BYTES, sigs[j], THREADS) == 0);
+		}
+		else{
+			CHECK(async_poll(jobs[j]) == ASYNC_CANCELLED && async_result(jobs[j]) == -1);
+		}
+		if (j > 0)
+			CHECK(async_progress(jobs[j]) == 0);
+	}
+	CHECK(atomic_load(&callbacks) == 2 + TEST_JOBS);
+
+	for (int j = 0; j < TEST_JOBS; ++j)
+	{
+		async_job_free(jobs[j]);
+		free(sigs[j]);
+	}
+	async_executor_free(executor);
+}
+
+// bounded verification gives up once its budget is spent, with enough budget it returns what verification does
+static void test_bounded(const unsigned char *pks, const unsigned char *sks, const unsigned char *message){
+	unsigned char *sig = aligned_alloc(32, SIG_BYTES(TEST_LOG_N));
+	uint64_t sig_len;
+	verify_budget unlimited = {0, 0};
+	verify_budget one_cycle = {1, 0};
+	verify_budget past = {0, 1};
+	verify_budget minute = {0, monotonic_ns() + 60000000000ull};
+
+	CHECK(RS(sign_mt)(sks + 3*SK_BYTES, 3, pks, TEST_RING, message, MESSAGE_BYTES, sig, &sig_len, THREADS) == 0);
+
+	CHECK(RS(verify_bounded)(pks, TEST_RING, message, MESSAGE_BYTES, sig, sig_len, THREADS, NULL) == 0);
+	CHECK(RS(verify_bounded)(pks, TEST_RING, message, MESSAGE_BYTES, sig, sig_len, THREADS, &unlimited) == 0);
+	CHECK(RS(verify_bounded)(pks, TEST_RING, message, MESSAGE_BYTES, sig, sig_len, THREADS, &minute) == 0);
+	CHECK(RS(verify_bounded)(pks, TEST_RING, message, MESSAGE_BYTES - 1, sig, sig_len, THREADS, &minute) == -1);
+
+	CHECK(RS(verify_bounded)(pks, TEST_RING, message, MESSAGE_BYTES, sig, sig_len, THREADS, &one_cycle) == VERIFY_BUDGET_EXCEEDED);
+	CHECK(RS(verify_bounded)(pks, TEST_RING, message, MESSAGE_BYTES, sig, sig_len, THREADS, &past) == VERIFY_BUDGET_EXCEEDED);
+
+	// a signature of the wrong length is rejected before any budget is spent
+	CHECK(RS(verify_bounded)(pks, TEST_RING, message, MESSAGE_BYTES, sig, sig_len - 1, THREADS, &past) == -1);
+	CHECK(RS(verify_bounded)(pks, TEST_RING, message, MESSAGE_BYTES, sig, sig_len + SEED_BYTES, THREADS, NULL) == -1);
+
+	// the budget cancels a control of its own, the control of the caller is left alone. a cancelled caller is not a used up budget
+	ring_ctx ring;
+	unsigned char message_hash[HASH_BYTES];
+	parallel_control control;
+	ring_ctx_view(&ring, pks, TEST_RING);
+	HASH(message, MESSAGE_BYTES, message_hash);
+	parallel_control_init(&control);
+	CHECK(verify_run(&ring, message_hash, sig, THREADS, NULL, &control, &one_cycle, LINKABLE) == VERIFY_BUDGET_EXCEEDED);
+	CHECK(!parallel_cancelled(&control));
+	parallel_control_init(&control);
+	CHECK(verify_run(&ring, message_hash, sig, THREADS, NULL, &control, &minute, LINKABLE) == 0);
+	CHECK(control.completed == EXECUTIONS);
+	parallel_cancel(&control);
+	CHECK(verify_run(&ring, message_hash, sig, THREADS, NULL, &control, &minute, LINKABLE) == -1);
+
+	free(sig);
+}
+
+// a limit that is reached at the poll after limit_allowed polls, to see where the members of a ring check it
+static atomic_int limit_polls;
+static int limit_allowed;
+
+static int count_polls(const void *arg, uint64_t cycles){
+	return atomic_fetch_add(&limit_polls, 1) + 1 > limit_allowed;
+}
+
+// the members of a ring check the control between every group of COMMIT_LANES members, so a used up budget or
+// a cancelled job stops in the middle of an execution
+#define TEST_BUDGET_RING (4*COMMIT_LANES)
+
+static void test_budget_members(const unsigned char *pks){
+	unsigned char *ring_pks = aligned_alloc(32, TEST_BUDGET_RING*PK_BYTES);
+	unsigned char seed[SEED_BYTES] = {4};
+	unsigned char salt[HASH_BYTES] = {5};
+	unsigned char root[HASH_BYTES], stopped_root[HASH_BYTES];
+	GRPELTS2 r[1];
+	init_grpelt(r[0]);
+	for (int j = 0; j < TEST_BUDGET_RING; ++j)
+	{
+		memcpy(ring_pks + j*PK_BYTES, pks + (j % TEST_RING)*PK_BYTES, PK_BYTES);
+	}
+
+	ring_ctx ring;
+	ring_ctx_view(&ring, ring_pks, TEST_BUDGET_RING);
+	unsigned char *buf = malloc(ring.buf_len + 1);
+	unsigned char *commitments = malloc(ring.commitments_len);
+	parallel_control control;
+
+	parallel_control_init(&control);
+	control.limit = count_polls;
+	limit_polls = 0;
+	limit_allowed = TEST_BUDGET_RING;
+	commit_to_ring(seed, 0, &ring, -1, salt, r, buf, commitments, NULL, root, NULL, 1, &control);
+	CHECK(limit_polls == TEST_BUDGET_RING/COMMIT_LANES);
+	CHECK(control.cycles > 0);
+
+	// stopped after the first group of members
+	parallel_control_init(&control);
+	control.limit = count_polls;
+	limit_polls = 0;
+	limit_allowed = 1;
+	commit_to_ring(seed, 0, &ring, -1, salt, r, buf, commitments, NULL, stopped_root, NULL, 1, &control);
+	CHECK(limit_polls == 2);
+	CHECK(parallel_cancelled(&control));
+	CHECK(memcmp(root, stopped_root, HASH_BYTES) != 0);
+
+	clear_grpelt(r[0]);
+	free(ring_pks);
+	free(buf);
+	free(commitments);
+}
+
+// splitting the ring members of an execution over threads gives the root, the path and the commitment randomness
+// of committing to them on one thread, also when the last group of members is not full
+static void test_member_threads(const unsigned char *pks){
+	unsigned char *ring_pks = aligned_alloc(32, TEST_BUDGET_RING*PK_BYTES);
+	unsigned char seed[SEED_BYTES] = {6};
+	unsigned char salt[HASH_BYTES] = {7};
+	unsigned char root[HASH_BYTES], split_root[HASH_BYTES];
+	unsigned char path[TEST_LOG_N*HASH_BYTES + 3*HASH_BYTES], split_path[TEST_LOG_N*HASH_BYTES + 3*HASH_BYTES];
+	unsigned char randomness[SEED_BYTES], split_randomness[SEED_BYTES];
+	GRPELTS2 r[1];
+	init_grpelt(r[0]);
+	for (int j = 0; j < TEST_BUDGET_RING; ++j)
+	{
+		memcpy(ring_pks + j*PK_BYTES, pks + (j % TEST_RING)*PK_BYTES, PK_BYTES);
+	}
+
+	for (int64_t rings = TEST_BUDGET_RING - 3; rings <= TEST_BUDGET_RING; rings += 3)
+	{
+		ring_ctx ring;
+		ring_ctx_view(&ring, ring_pks, rings);
+		unsigned char *buf = malloc(ring.buf_len + 1);
+		unsigned char *commitments = malloc(ring.commitments_len);
+
+		for (int64_t I = 0; I < rings; I += rings/2)
+		{
+			commit_to_ring(seed, 1, &ring, I, salt, r, buf, commitments, randomness, root, path, 1, NULL);
+			for (int threads = 2; threads <= 8; threads *= 2)
+			{
+				commit_to_ring(seed, 1, &ring, I, salt, r, buf, commitments, split_randomness, split_root, split_path, threads, NULL);
+				CHECK(memcmp(root, split_root, HASH_BYTES) == 0);
+				CHECK(memcmp(path, split_path, ring.logN*HASH_BYTES) == 0);
+				CHECK(memcmp(randomness, split_randomness, SEED_BYTES) == 0);
+			}
+		}
+		free(buf);
+		free(commitments);
+	}
+
+	clear_grpelt(r[0]);
+	free(ring_pks);
+}
+
+// the verify cache answers a signature it verified before from the cache, never caches an invalid signature,
+// and evicts the least recently used signatures once it is full
+#define TEST_CACHE_INSERTIONS 1000
+
+static void test_verify_cache(const unsigned char *pks, const unsigned char *sks, const unsigned char *message){
+	unsigned char *sig = aligned_alloc(32, SIG_BYTES(TEST_LOG_N));
+	uint64_t sig_len;
+	ring_ctx ring;
+	verify_cache_stats stats;
+	unsigned char key[VERIFY_CACHE_KEY_BYTES];
+	unsigned char message_hash[HASH_BYTES] = {0};
+
+	CHECK(ring_ctx_init(&ring, pks, TEST_RING) == 0);
+	verify_cache *cache = verify_cache_new(VERIFY_CACHE_SHARDS);
+	CHECK(RS(sign_mt)(sks, 0, pks, TEST_RING, message, MESSAGE_BYTES, sig, &sig_len, THREADS) == 0);
+
+	CHECK(RS(verify_cached)(cache, &ring, message, MESSAGE_BYTES, sig, sig_len, THREADS) == 0);
+	CHECK(RS(verify_cached)(cache, &ring, message, MESSAGE_BYTES, sig, sig_len, THREADS) == 0);
+	verify_cache_get_stats(cache, &stats);
+	CHECK(stats.hits == 1 && stats.misses == 1 && stats.insertions == 1 && stats.entries == 1);
+
+	CHECK(RS(verify_cached)(cache, &ring, message, MESSAGE_BYTES - 1, sig, sig_len, THREADS) != 0);
+	CHECK(RS(verify_cached)(cache, &ring, message, MESSAGE_BYTES - 1, sig, sig_len, THREADS) != 0);
+	verify_cache_get_stats(cache, &stats);
+	CHECK(stats.hits == 1 && stats.misses == 3 && stats.insertions == 1);
+
+	// many more signatures than the cache holds push out the first one
+	for (int k = 0; k < TEST_CACHE_INSERTIONS; ++k)
+	{
+		message_hash[0] = k;
+		message_hash[1] = k >> 8;
+		verify_cache_key(ring.digest, message_hash, sig, sig_len, 0, key);
+		verify_cache_insert(cache, key);
+		CHECK(verify_cache_lookup(cache, key));
+	}
+	verify_cache_get_stats(cache, &stats);
+	CHECK(stats.entries <= stats.capacity && stats.evictions >= TEST_CACHE_INSERTIONS + 1 - stats.capacity);
+
+	CHECK(RS(verify_cached)(cache, &ring, message, MESSAGE_BYTES, sig, sig_len, THREADS) == 0);
+	verify_cache_get_stats(cache, &stats);
+	CHECK(stats.hits == 1 + TEST_CACHE_INSERTIONS && stats.misses == 4);
+
+	// a signature that is cached as valid for one ring is still rejected for another ring, viewed or copied
+	unsigned char *other_pks = aligned_alloc(32, TEST_RING*PK_BYTES);
+	unsigned char other_sk[SK_BYTES];
+	memcpy(other_pks, pks, TEST_RING*PK_BYTES);
+	keygen(other_pks + (TEST_RING-1)*PK_BYTES, other_sk);
+	ring_ctx view, other_view, other_ring;
+	CHECK(ring_ctx_view(&view, pks, TEST_RING) == 0);
+	CHECK(ring_ctx_view(&other_view, other_pks, TEST_RING) == 0);
+	CHECK(ring_ctx_init(&other_ring, other_pks, TEST_RING) == 0);
+	CHECK(RS(verify_cached)(cache, &view, message, MESSAGE_BYTES, sig, sig_len, THREADS) == 0);
+	CHECK(RS(verify_cached)(cache, &other_view, message, MESSAGE_BYTES, sig, sig_len, THREADS) != 0);
+	CHECK(RS(verify_cached)(cache, &other_ring, message, MESSAGE_BYTES, sig, sig_len, THREADS) != 0);
+	ring_ctx_clear(&other_ring);
+	free(other_pks);
+
+	verify_cache_free(cache);
+	ring_ctx_clear(&ring);
+	free(sig);
+}
+
+// commit_batch gives the commitments of commit, for every number of lanes and a partial last group
+#define TEST_COMMITS (2*COMMIT_LANES + 1)
+
+static void test_commit_batch(void){
+	XELT *R = malloc(TEST_COMMITS*sizeof(XELT));
+	unsigned char randomness[TEST_COMMITS][SEED_BYTES];
+	unsigned char commitments[TEST_COMMITS][HASH_BYTES], expected[TEST_COMMITS][HASH_BYTES];
+	const unsigned char *randomness_lanes[TEST_COMMITS];
+	unsigned char *commitment_lanes[TEST_COMMITS];
+	unsigned char salt[HASH_BYTES] = {0};
+
+	for (int k = 0; k < TEST_COMMITS; ++k)
+	{
+		for (uint64_t j = 0; j < sizeof(XELT); ++j)
+		{
+			((unsigned char *) &R[k])[j] = (unsigned char) (j*7 + k*13);
+		}
+		memset(randomness[k], 3*k + 1, SEED_BYTES);
+		randomness_lanes[k] = randomness[k];
+		commitment_lanes[k] = commitments[k];
+		commit(&R[k], randomness[k], salt, expected[k]);
+	}
+
+	for (int count = 1; count <= TEST_COMMITS; ++count)
+	{
+		memset(commitments, 0, sizeof(commitments));
+		commit_batch(R, randomness_lanes, salt, commitment_lanes, count);
+		CHECK(memcmp(commitments, expected, count*HASH_BYTES) == 0);
+		CHECK(count == TEST_COMMITS || commitments[count][0] == 0);
+	}
+
+	free(R);
+}
+
+// the streaming treehash gives the root, the path and the commitment randomness of commit_to_ring for a ring that is
+// not streamed, for every signer and for one or more subtrees. the view is first compared as it is, with the randomness
+// of this build, and then with the other randomness. the streaming views are made streaming by hand
+static void test_streaming_root(const unsigned char *pks){
+	unsigned char seed[SEED_BYTES] = {1};
+	unsigned char salt[HASH_BYTES] = {2};
+	unsigned char root[HASH_BYTES], streamed_root[HASH_BYTES];
+	unsigned char path[TEST_LOG_N*HASH_BYTES], streamed_path[TEST_LOG_N*HASH_BYTES];
+	unsigned char randomness[SEED_BYTES], streamed_randomness[SEED_BYTES];
+	GRPELTS2 r[1], streamed_r[1];
+	init_grpelt(r[0]);
+	init_grpelt(streamed_r[0]);
+
+	for (int64_t rings = 1; rings <= TEST_RING; ++rings)
+	{
+		for (int other = 0; other <= 1; ++other)
+		{
+			ring_ctx in_memory, streaming;
+			ring_ctx_view(&in_memory, pks, rings);
+			ring_ctx_view(&streaming, pks, rings);
+			if (other){
+				in_memory.counter = !COUNTER_RANDOMNESS;
+				in_memory.buf_len = in_memory.counter ? 0 : SEED_BYTES*(rings+2);
+			}
+			streaming.streaming = 1;
+			streaming.counter = in_memory.counter;
+			streaming.buf_len = 0;
+			streaming.commitments_len = HASH_BYTES;
+			unsigned char *buf = malloc(in_memory.buf_len + 1);
+			unsigned char *commitments = malloc(in_memory.commitments_len);
+
+			for (int64_t I = 0; I < rings; ++I)
+			{
+				commit_to_ring(seed, 3, &in_memory, I, salt, r, buf, commitments, randomness, root, path, 1, NULL);
+				for (int threads = 1; threads <= 4; ++threads)
+				{
+					memset(streamed_path, 0, sizeof(streamed_path));
+					commit_to_ring(seed, 3, &streaming, I, salt, streamed_r, NULL, NULL, streamed_randomness, streamed_root, streamed_path, threads, NULL);
+					CHECK(memcmp(root, streamed_root, HASH_BYTES) == 0);
+					CHECK(memcmp(path, streamed_path, in_memory.logN*HASH_BYTES) == 0);
+					CHECK(memcmp(randomness, streamed_randomness, SEED_BYTES) == 0);
+				}
+			}
+			free(buf);
+			free(commitments);
+		}
+	}
+
+	clear_grpelt(r[0]);
+	clear_grpelt(streamed_r[0]);
+}
+
+// with counter randomness the randomness of member I of execution i is the hash of the seed, the salt, EXECUTIONS+i
+// and I. the ring is then committed to without an expansion buffer, with the same root on any number of member
+// threads, and the root differs from that of the expanded randomness
+static void test_counter_randomness(const unsigned char *pks){
+	unsigned char *ring_pks = aligned_alloc(32, TEST_BUDGET_RING*PK_BYTES);
+	unsigned char seed[SEED_BYTES] = {8};
+	unsigned char salt[HASH_BYTES] = {9};
+	unsigned char root[HASH_BYTES], split_root[HASH_BYTES], expanded_root[HASH_BYTES];
+	unsigned char path[TEST_LOG_N*HASH_BYTES + 3*HASH_BYTES], split_path[TEST_LOG_N*HASH_BYTES + 3*HASH_BYTES];
+	unsigned char randomness[SEED_BYTES];
+	unsigned char in[SEED_BYTES + HASH_BYTES + sizeof(uint32_t) + sizeof(int64_t)];
+	unsigned char expected[HASH_BYTES];
+	uint32_t execution = EXECUTIONS + 5;
+	GRPELTS2 r[1];
+	init_grpelt(r[0]);
+	for (int j = 0; j < TEST_BUDGET_RING; ++j)
+	{
+		memcpy(ring_pks + j*PK_BYTES, pks + (j % TEST_RING)*PK_BYTES, PK_BYTES);
+	}
+
+	ring_ctx counter, expanded;
+	ring_ctx_view(&counter, ring_pks, TEST_BUDGET_RING);
+	ring_ctx_view(&expanded, ring_pks, TEST_BUDGET_RING);
+	counter.counter = 1;
+	counter.buf_len = 0;
+	expanded.counter = 0;
+	expanded.buf_len = SEED_BYTES*(TEST_BUDGET_RING+2);
+	unsigned char *buf = malloc(expanded.buf_len);
+	unsigned char *commitments = malloc(counter.commitments_len);
+
+	memcpy(in, seed, SEED_BYTES);
+	memcpy(in + SEED_BYTES, salt, HASH_BYTES);
+	memcpy(in + SEED_BYTES + HASH_BYTES, &execution, sizeof(uint32_t));
+	for (int64_t I = 0; I < TEST_BUDGET_RING; I += 5)
+	{
+		commit_to_ring(seed, 5, &counter, I, salt, r, NULL, commitments, randomness, root, path, 1, NULL);
+		memcpy(in + SEED_BYTES + HASH_BYTES + sizeof(uint32_t), &I, sizeof(int64_t));
+		HASH(in, sizeof(in), expected);
+		CHECK(memcmp(randomness, expected, SEED_BYTES) == 0);
+
+		for (int threads = 2; threads <= 4; threads *= 2)
+		{
+			commit_to_ring(seed, 5, &counter, I, salt, r, NULL, commitments, randomness, split_root, split_path, threads, NULL);
+			CHECK(memcmp(root, split_root, HASH_BYTES) == 0);
+			CHECK(memcmp(path, split_path, counter.logN*HASH_BYTES) == 0);
+		}
+
+		commit_to_ring(seed, 5, &expanded, I, salt, r, buf, commitments, NULL, expanded_root, split_path, 1, NULL);
+		CHECK(memcmp(root, expanded_root, HASH_BYTES) != 0);
+	}
+
+	clear_grpelt(r[0]);
+	free(ring_pks);
+	free(buf);
+	free(commitments);
+}
+
+// a tree of 2^k+1 leaves that is completed with one dummy node per level gives every leaf a path of logN nodes
+// to the same root
+#define TEST_TREE_LOG_N 6
+
+static void test_unpadded_tree(void){
+	unsigned char *leaves = malloc(((1 << TEST_TREE_LOG_N) + 1 + TEST_TREE_LOG_N)*HASH_BYTES);
+	unsigned char *commitments = malloc(((1 << TEST_TREE_LOG_N) + 1 + TEST_TREE_LOG_N)*HASH_BYTES);
+	uint64_t path[4*TEST_TREE_LOG_N];
+	unsigned char root[HASH_BYTES], leaf_root[HASH_BYTES], reconstructed[HASH_BYTES];
+
+	for (int k = 1; k < TEST_TREE_LOG_N; ++k)
+	{
+		int64_t count = (1 << k) + 1;
+		int logN = log_round_up(count);
+		CHECK(logN == k + 1);
+		for (int64_t j = 0; j < (count + logN)*HASH_BYTES; ++j)
+		{
+			leaves[j] = (unsigned char) (j*29 + k);
+		}
+
+		memcpy(commitments, leaves, (count + logN)*HASH_BYTES);
+		build_unbalanced_tree_and_path(commitments, count, -1, root, NULL);
+
+		for (int64_t I = 0; I < count; ++I)
+		{
+			memcpy(commitments, leaves, (count + logN)*HASH_BYTES);
+			build_unbalanced_tree_and_path(commitments, count, I, leaf_root, (unsigned char *) path);
+			CHECK(memcmp(root, leaf_root, HASH_BYTES) == 0);
+
+			reconstruct_root(leaves + I*HASH_BYTES, (unsigned char *) path, logN, reconstructed);
+			CHECK(memcmp(root, reconstructed, HASH_BYTES) == 0);
+		}
+	}
+
+	CHECK(RING_TREE_NODES(TEST_RING) == (UNPADDED_TREE ? TEST_RING + TEST_LOG_N : 1 << TEST_LOG_N));
+
+	free(leaves);
+	free(commitments);
+}
+
+// the seed tree as it was expanded before it was done a level at a time, one node after the other from the root
+static void reference_seed_tree(unsigned char *seed_tree, uint64_t leaves, const unsigned char *salt){
+	unsigned char buf[HASH_BYTES + SEED_BYTES + sizeof(uint32_t)];
+	memcpy(buf, salt, HASH_BYTES);
+	for (uint32_t i = 0; i < leaves-1; i++)
+	{
+		memcpy(buf + HASH_BYTES, seed_tree + i*SEED_BYTES, SEED_BYTES);
+		memcpy(buf + HASH_BYTES + SEED_BYTES, &i, sizeof(uint32_t));
+		EXPAND(buf, sizeof(buf), seed_tree + (2*i + 1)*SEED_BYTES, 2*SEED_BYTES);
+	}
+}
+
+// the level-wise seed tree has the seeds of the recursive one, and fill_down recovers the leaves of the released seeds
+static void test_seed_tree(void){
+	const uint64_t sizes[] = {2, 5, 16, EXECUTIONS};
+	unsigned char salt[HASH_BYTES];
+	for (int k = 0; k < HASH_BYTES; ++k)
+	{
+		salt[k] = 5*k;
+	}
+
+	for (int s = 0; s < 4; ++s)
+	{
+		uint64_t leaves = sizes[s];
+		unsigned char *tree = malloc((2*leaves - 1)*SEED_BYTES);
+		unsigned char *reference = malloc((2*leaves - 1)*SEED_BYTES);
+		unsigned char *filled = calloc(2*leaves - 1, SEED_BYTES);
+		unsigned char *released = malloc(leaves*SEED_BYTES);
+		unsigned char indices[leaves];
+		uint64_t seeds_released, nodes_used;
+
+		generate_seed_tree(tree, leaves, salt);
+		memcpy(reference, tree, SEED_BYTES);
+		reference_seed_tree(reference, leaves, salt);
+		CHECK(memcmp(tree, reference, (2*leaves - 1)*SEED_BYTES) == 0);
+
+		for (uint64_t i = 0; i < leaves; ++i)
+		{
+			indices[i] = (i % 3) != 1;
+		}
+		release_seeds(tree, leaves, indices, released, &seeds_released);
+		CHECK(seeds_released == count_released_seeds(leaves, indices));
+		fill_down(filled, leaves, indices, released, &nodes_used, salt);
+		CHECK(nodes_used == seeds_released);
+		for (uint64_t i = 0; i < leaves; ++i)
+		{
+			if (indices[i])
+				CHECK(memcmp(filled + (leaves - 1 + i)*SEED_BYTES, reference + (leaves - 1 + i)*SEED_BYTES, SEED_BYTES) == 0);
+		}
+
+		free(tree);
+		free(reference);
+		free(filled);
+		free(released);
+	}
+}
+
+// a signature records the format variant it was made with, and a signature of another variant is reported as such
+static void test_format(const unsigned char *pks, const unsigned char *sks, const unsigned char *message){
+	unsigned char *sig = aligned_alloc(32, SIG_BYTES(TEST_LOG_N));
+	unsigned char *other = aligned_alloc(32, SIG_BYTES(TEST_LOG_N));
+	uint64_t sig_len;
+	int results[2];
+
+	CHECK(RS(sign_mt)(sks + SK_BYTES, 1, pks, TEST_RING, message, MESSAGE_BYTES, sig, &sig_len, THREADS) == 0);
+	CHECK(*SIG_FORMAT_BYTE(sig) == SIG_FORMAT);
+
+	// the same signature as if it was made with the other hash suite
+	memcpy(other, sig, sig_len);
+	*SIG_FORMAT_BYTE(other) ^= HASH_SUITE_TURBOSHAKE128;
+	CHECK(RS(verify_mt)(pks, TEST_RING, message, MESSAGE_BYTES, other, THREADS) == VERIFY_FORMAT_MISMATCH);
+	CHECK(RS(verify_bounded)(pks, TEST_RING, message, MESSAGE_BYTES, other, sig_len, THREADS, NULL) == VERIFY_FORMAT_MISMATCH);
+
+	const unsigned char *ms[2] = {message, message};
+	const uint64_t mlens[2] = {MESSAGE_BYTES, MESSAGE_BYTES};
+	const unsigned char *sigs[2] = {sig, other};
+	CHECK(RS(verify_batch)(pks, TEST_RING, ms, mlens, sigs, 2, results, THREADS) != 0);
+	CHECK(results[0] == 0 && results[1] == VERIFY_FORMAT_MISMATCH);
+
+	free(sig);
+	free(other);
+}
+
+// a signing job checks its control between the members of every execution, not only between the executions,
+// and stops when it is cancelled in the middle
+static void test_cancel_members(const unsigned char *pks, const unsigned char *sks, const unsigned char *message){
+	unsigned char *sig = aligned_alloc(32, SIG_BYTES(TEST_LOG_N));
+	uint64_t sig_len;
+	unsigned char message_hash[HASH_BYTES];
+	HASH(message, MESSAGE_BYTES, message_hash);
+	parallel_control control;
+
+	parallel_control_init(&control);
+	control.limit = count_polls;
+	atomic_store(&limit_polls, 0);
+	limit_allowed = 1 << 30;
+	CHECK(RS(sign_controlled)(sks, 0, pks, TEST_RING, message_hash, sig, &sig_len, THREADS, &control) == 0);
+	CHECK(atomic_load(&limit_polls) >= 2*EXECUTIONS);
+	CHECK(RS(verify)(pks, TEST_RING, message, MESSAGE_BYTES, sig) == 0);
+
+	parallel_control_init(&control);
+	control.limit = count_polls;
+	atomic_store(&limit_polls, 0);
+	limit_allowed = EXECUTIONS;
+	CHECK(RS(sign_controlled)(sks, 0, pks, TEST_RING, message_hash, sig, &sig_len, THREADS, &control) == -1);
+	CHECK(parallel_cancelled(&control));
+	CHECK(control.completed < EXECUTIONS);
+
+	free(sig);
+}
+
+static void behavior_tests(void){
+	unsigned char *pks = aligned_alloc(32, TEST_RING*PK_BYTES);
+	unsigned char *sks = aligned_alloc(32, TEST_RING*SK_BYTES);
+	unsigned char message[MESSAGE_BYTES];
+	for (int i = 0; i < TEST_RING; ++i)
+	{
+		keygen(pks + i*PK_BYTES, sks + i*SK_BYTES);
+	}
+	for (int i = 0; i < MESSAGE_BYTES; ++i)
+	{
+		message[i] = i;
+	}
+
+	test_sign_threads(pks, sks, message);
+	test_verify_threads(pks, sks, message);
+	test_speculative(pks, sks, message);
+	test_presign_once(pks, sks, message);
+	test_workspace(pks, sks, message);
+	test_lowmem(pks, sks, message);
+	test_batch(pks, sks);
+	test_ring_ctx(pks, sks, message);
+	test_message_hash(pks, sks, message);
+	test_async(pks, sks, message);
+	test_bounded(pks, sks, message);
+	test_budget_members(pks);
+	test_cancel_members(pks, sks, message);
+	test_member_threads(pks);
+	test_verify_cache(pks, sks, message);
+	test_commit_batch();
+	test_streaming_root(pks);
+	test_counter_randomness(pks);
+	test_unpadded_tree();
+	test_seed_tree();
+	test_format(pks, sks, message);
+
+	printf("behavior tests :      %s \n\n", failures ? "FAILED" : "OK");
+
+	free(pks);
+	free(sks);
+}
+
+// the benchmark signs and verifies with the serial sign and verify first, then with the other modes
+#define MODES 3
+static const char *const mode_names[MODES] = {"serial", "threaded", "speculative"};
+
+static int bench_sign(int mode, const unsigned char *sk, const int64_t I, const unsigned char *pks, const unsigned char *m, unsigned char *sig, uint64_t *sig_len){
+	if (mode == 1)
+		return RS(sign_mt)(sk, I, pks, KEYGENS, m, MESSAGE_BYTES, sig, sig_len, THREADS);
+	if (mode == 2)
+		return RS(sign_speculative)(sk, I, pks, KEYGENS, m, MESSAGE_BYTES, sig, sig_len, THREADS, CANDIDATES);
+	return sign(sk, I, pks, KEYGENS, m, MESSAGE_BYTES, sig, sig_len);
+}
+
+static int bench_verify(int mode, const unsigned char *pks, const unsigned char *m, const unsigned char *sig){
+	if (mode != 0)
+		return RS(verify_mt)(pks, KEYGENS, m, MESSAGE_BYTES, sig, THREADS);
+	return verify(pks, KEYGENS, m, MESSAGE_BYTES, sig);
+}
+
 int main(int argc, char const *argv[])
 {
 	init_action();
@@ -43,16 +1022,18 @@ int main(int argc, char const *argv[])
 
 	clock_t t0;
 	double keygenTime = 0;
-	double signTime = 0;
-	double verifyTime = 0;
-	uint64_t signature_size = 0;
 	uint64_t keygenCycles = 0;
-	uint64_t signCycles = 0;
-	uint64_t verifyCycles = 0;
 	uint64_t t;
 
 	printf("PK BYTES %ld \n", (long int) PK_BYTES);
 	printf("SK BYTES %ld \n", (long int) SK_BYTES);
+	printf("THREADS %d \n", THREADS);
+	printf("CANDIDATES %d \n", CANDIDATES);
+	printf("HASH SUITE %s \n", (HASH_SUITE == HASH_SUITE_TURBOSHAKE128) ? "TurboSHAKE128" : "SHAKE128");
+	printf("KECCAK BACKEND %s \n", keccak_selected->name);
+
+	if (BEHAVIOR_TESTS)
+		behavior_tests();
 
 	for (int i = 0; i < KEYGENS ; ++i)
 	{
@@ -72,43 +1053,55 @@ int main(int argc, char const *argv[])
 	unsigned char message[MESSAGE_BYTES] = {0};
 	unsigned char *sig = aligned_alloc(32,SIG_BYTES(LOG_N));
 
-	for (int i = 0; i < SIGNINGS; ++i)
+	for (int mode = 0; mode < MODES; ++mode)
 	{
-		//printf("signing #%d \n", i);
-		uint64_t ss;
+		double signTime = 0;
+		double verifyTime = 0;
+		uint64_t signature_size = 0;
+		uint64_t signCycles = 0;
+		uint64_t verifyCycles = 0;
+		restarts = 0;
 
-		t0 = clock();
-		t = rdtsc();
-		sign(sks + (i%KEYGENS)*SK_BYTES, i%KEYGENS, pks, KEYGENS, message, MESSAGE_BYTES, sig, &ss);
-		signCycles += rdtsc()-t;
-		signTime += 1000. * (clock() - t0) / CLOCKS_PER_SEC;
-		signature_size += ss;
+		printf("%s : \n\n", mode_names[mode]);
 
-		//printf("verify #%d \n", i);
+		for (int i = 0; i < SIGNINGS; ++i)
+		{
+			//printf("signing #%d \n", i);
+			uint64_t ss;
 
-		t0 = clock();
-		t = rdtsc();
-		int ver = verify(pks, KEYGENS, message, MESSAGE_BYTES, sig);
-		verifyCycles += rdtsc()-t;
-		verifyTime += 1000. * (clock() - t0) / CLOCKS_PER_SEC;
+			t0 = clock();
+			t = rdtsc();
+			bench_sign(mode, sks + (i%KEYGENS)*SK_BYTES, i%KEYGENS, pks, message, sig, &ss);
+			signCycles += rdtsc()-t;
+			signTime += 1000. * (clock() - t0) / CLOCKS_PER_SEC;
+			signature_size += ss;
 
-		if( ver  != 0){
-			printf("signature #%d does not verify successfully! \n", i);
+			//printf("verify #%d \n", i);
+
+			t0 = clock();
+			t = rdtsc();
+			int ver = bench_verify(mode, pks, message, sig);
+			verifyCycles += rdtsc()-t;
+			verifyTime += 1000. * (clock() - t0) / CLOCKS_PER_SEC;
+
+			if( ver  != 0){
+				printf("signature #%d does not verify successfully! \n", i);
+			}
 		}
-	}
 
-	printf("signing cycles :      %lu \n", signCycles/SIGNINGS );
-	printf("signing time :        %.1lf ms \n\n", signTime/SIGNINGS );
+		printf("signing cycles :      %lu \n", signCycles/SIGNINGS );
+		printf("signing time :        %.1lf ms \n\n", signTime/SIGNINGS );
 
-	printf("signature size :      %lu bytes \n\n", signature_size/SIGNINGS);
+		printf("signature size :      %lu bytes \n\n", signature_size/SIGNINGS);
 
-	printf("verification cycles : %lu \n", verifyCycles/SIGNINGS );
-	printf("verification time :   %.1lf ms \n", verifyTime/SIGNINGS );
-	printf("restarts: %ld \n", restarts);
+		printf("verification cycles : %lu \n", verifyCycles/SIGNINGS );
+		printf("verification time :   %.1lf ms \n", verifyTime/SIGNINGS );
+		printf("restarts: %ld \n\n", restarts);
+	}
 
 	free(pks);
 	free(sks);
 	free(sig);
 
-	return 0;
+	return failures != 0;
 }
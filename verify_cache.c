@@ -0,0 +1,254 @@
+#include "verify_cache.h"
+#include <pthread.h>
+#include <stdlib.h>
+
+#define NONE -1
+
+typedef struct {
+	unsigned char key[VERIFY_CACHE_KEY_BYTES];
+	int64_t next_in_bucket;
+	// least recently used list, newer towards head
+	int64_t newer;
+	int64_t older;
+} cache_entry;
+
+typedef struct {
+	pthread_mutex_t lock;
+	cache_entry *entries;
+	int64_t *buckets;
+	uint64_t bucket_mask;
+	uint64_t capacity;
+	uint64_t used;
+	int64_t head;
+	int64_t tail;
+	uint64_t hits;
+	uint64_t misses;
+	uint64_t insertions;
+	uint64_t evictions;
+} cache_shard;
+
+struct verify_cache {
+	uint64_t capacity;
+	cache_shard shards[VERIFY_CACHE_SHARDS];
+};
+
+// the keys are hashes, so their bytes can be used as they are
+static cache_shard *shard_of(verify_cache *cache, const unsigned char *key){
+	return &cache->shards[key[0] % VERIFY_CACHE_SHARDS];
+}
+
+static uint64_t bucket_of(const cache_shard *shard, const unsigned char *key){
+	uint64_t h;
+	memcpy(&h, key + 1, sizeof(h));
+	return h & shard->bucket_mask;
+}
+
+static void shard_reset(cache_shard *shard){
+	for (uint64_t b = 0; b <= shard->bucket_mask; ++b)
+	{
+		shard->buckets[b] = NONE;
+	}
+	shard->used = 0;
+	shard->head = NONE;
+	shard->tail = NONE;
+}
+
+static void unlink_lru(cache_shard *shard, int64_t e){
+	cache_entry *entry = &shard->entries[e];
+	if (entry->newer != NONE)
+		shard->entries[entry->newer].older = entry->older;
+	else
+		shard->head = entry->older;
+	if (entry->older != NONE)
+		shard->entries[entry->older].newer = entry->newer;
+	else
+		shard->tail = entry->newer;
+}
+
+static void push_lru(cache_shard *shard, int64_t e){
+	cache_entry *entry = &shard->entries[e];
+	entry->newer = NONE;
+	entry->older = shard->head;
+	if (shard->head != NONE)
+		shard->entries[shard->head].newer = e;
+	else
+		shard->tail = e;
+	shard->head = e;
+}
+
+static int64_t find(cache_shard *shard, const unsigned char *key){
+	for (int64_t e = shard->buckets[bucket_of(shard, key)]; e != NONE; e = shard->entries[e].next_in_bucket)
+	{
+		if (memcmp(shard->entries[e].key, key, VERIFY_CACHE_KEY_BYTES) == 0)
+			return e;
+	}
+	return NONE;
+}
+
+static void remove_from_bucket(cache_shard *shard, int64_t e){
+	int64_t *link = &shard->buckets[bucket_of(shard, shard->entries[e].key)];
+	while (*link != e){
+		link = &shard->entries[*link].next_in_bucket;
+	}
+	*link = shard->entries[e].next_in_bucket;
+}
+
+verify_cache *verify_cache_new(uint64_t capacity){
+	verify_cache *cache = calloc(1, sizeof(verify_cache));
+	if (cache == NULL)
+		return NULL;
+
+	uint64_t per_shard = (capacity + VERIFY_CACHE_SHARDS - 1)/VERIFY_CACHE_SHARDS;
+	if (per_shard == 0)
+		per_shard = 1;
+	cache->capacity = per_shard*VERIFY_CACHE_SHARDS;
+
+	// about two buckets per entry keeps the chains short
+	uint64_t buckets = 1;
+	while (buckets < 2*per_shard){
+		buckets <<= 1;
+	}
+
+	for (int s = 0; s < VERIFY_CACHE_SHARDS; ++s)
+	{
+		pthread_mutex_init(&cache->shards[s].lock, NULL);
+	}
+
+	for (int s = 0; s < VERIFY_CACHE_SHARDS; ++s)
+	{
+		cache_shard *shard = &cache->shards[s];
+		shard->capacity = per_shard;
+		shard->bucket_mask = buckets - 1;
+		shard->entries = malloc(per_shard*sizeof(cache_entry));
+		shard->buckets = malloc(buckets*sizeof(int64_t));
+		if (shard->entries == NULL || shard->buckets == NULL){
+			verify_cache_free(cache);
+			return NULL;
+		}
+		shard_reset(shard);
+	}
+	return cache;
+}
+
+void verify_cache_free(verify_cache *cache){
+	for (int s = 0; s < VERIFY_CACHE_SHARDS; ++s)
+	{
+		pthread_mutex_destroy(&cache->shards[s].lock);
+		free(cache->shards[s].entries);
+		free(cache->shards[s].buckets);
+	}
+	free(cache);
+}
+
+void verify_cache_clear(verify_cache *cache){
+	for (int s = 0; s < VERIFY_CACHE_SHARDS; ++s)
+	{
+		pthread_mutex_lock(&cache->shards[s].lock);
+		shard_reset(&cache->shards[s]);
+		pthread_mutex_unlock(&cache->shards[s].lock);
+	}
+}
+
+void verify_cache_get_stats(verify_cache *cache, verify_cache_stats *stats){
+	memset(stats, 0, sizeof(verify_cache_stats));
+	stats->capacity = cache->capacity;
+	for (int s = 0; s < VERIFY_CACHE_SHARDS; ++s)
+	{
+		cache_shard *shard = &cache->shards[s];
+		pthread_mutex_lock(&shard->lock);
+		stats->hits += shard->hits;
+		stats->misses += shard->misses;
+		stats->insertions += shard->insertions;
+		stats->evictions += shard->evictions;
+		stats->entries += shard->used;
+		pthread_mutex_unlock(&shard->lock);
+	}
+}
+
+void verify_cache_key(const unsigned char *ring_digest, const unsigned char *message_hash, const unsigned char *sig, uint64_t sig_len, int linkable, unsigned char *key){
+	unsigned char buf[1 + 3*HASH_BYTES];
+	buf[0] = linkable ? 1 : 0;
+	memcpy(buf + 1, ring_digest, HASH_BYTES);
+	memcpy(buf + 1 + HASH_BYTES, message_hash, HASH_BYTES);
+	HASH(sig, sig_len, buf + 1 + 2*HASH_BYTES);
+	HASH(buf, sizeof(buf), key);
+}
+
+int verify_cache_lookup(verify_cache *cache, const unsigned char *key){
+	cache_shard *shard = shard_of(cache, key);
+	pthread_mutex_lock(&shard->lock);
+	int64_t e = find(shard, key);
+	if (e != NONE){
+		unlink_lru(shard, e);
+		push_lru(shard, e);
+		shard->hits++;
+	}
+	else{
+		shard->misses++;
+	}
+	pthread_mutex_unlock(&shard->lock);
+	return e != NONE;
+}
+
+void verify_cache_insert(verify_cache *cache, const unsigned char *key){
+	cache_shard *shard = shard_of(cache, key);
+	pthread_mutex_lock(&shard->lock);
+
+	// another thread may have verified the same signature in the meantime
+	if (find(shard, key) != NONE){
+		pthread_mutex_unlock(&shard->lock);
+		return;
+	}
+
+	int64_t e;
+	if (shard->used < shard->capacity){
+		e = shard->used++;
+	}
+	else{
+		e = shard->tail;
+		unlink_lru(shard, e);
+		remove_from_bucket(shard, e);
+		shard->evictions++;
+	}
+
+	cache_entry *entry = &shard->entries[e];
+	memcpy(entry->key, key, VERIFY_CACHE_KEY_BYTES);
+	uint64_t b = bucket_of(shard, key);
+	entry->next_in_bucket = shard->buckets[b];
+	shard->buckets[b] = e;
+	push_lru(shard, e);
+	shard->insertions++;
+
+	pthread_mutex_unlock(&shard->lock);
+}
+
+static int verify_cached(verify_cache *cache, const ring_ctx *ring, const unsigned char *m, uint64_t mlen, const unsigned char *sig, uint64_t sig_len, int threads, int linkable){
+	unsigned char message_hash[HASH_BYTES];
+	HASH(m,mlen,message_hash);
+
+	// a viewed ring has no digest and its keys are owned by the caller, so they are hashed on every call
+	unsigned char digest[HASH_BYTES];
+	const unsigned char *ring_digest = ring->digest;
+	if (ring->allocated == NULL){
+		HASH(ring->pks, ring->rings*PK_BYTES, digest);
+		ring_digest = digest;
+	}
+
+	unsigned char key[VERIFY_CACHE_KEY_BYTES];
+	verify_cache_key(ring_digest, message_hash, sig, sig_len, linkable, key);
+	if (verify_cache_lookup(cache, key))
+		return 0;
+
+	int valid = verify_bounded_prehashed(ring, message_hash, sig, sig_len, threads, NULL, linkable);
+	if (valid == 0)
+		verify_cache_insert(cache, key);
+	return valid;
+}
+
+int rverify_cached(verify_cache *cache, const ring_ctx *ring, const unsigned char *m, uint64_t mlen, const unsigned char *sig, uint64_t sig_len, int threads){
+	return verify_cached(cache, ring, m, mlen, sig, sig_len, threads, 0);
+}
+
+int lrverify_cached(verify_cache *cache, const ring_ctx *ring, const unsigned char *m, uint64_t mlen, const unsigned char *sig, uint64_t sig_len, int threads){
+	return verify_cached(cache, ring, m, mlen, sig, sig_len, threads, 1);
+}
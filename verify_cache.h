@@ -0,0 +1,39 @@
+#ifndef VERIFY_CACHE_H
+#define VERIFY_CACHE_H
+
+#include "rsign.h"
+#include "lrsign.h"
+#include "stdint.h"
+
+// the cache is split in shards with a lock each, so that concurrent lookups rarely wait on each other
+#define VERIFY_CACHE_SHARDS 16
+#define VERIFY_CACHE_KEY_BYTES HASH_BYTES
+
+typedef struct verify_cache verify_cache;
+
+typedef struct {
+	uint64_t hits;
+	uint64_t misses;
+	uint64_t insertions;
+	uint64_t evictions;
+	uint64_t entries;
+	uint64_t capacity;
+} verify_cache_stats;
+
+// remembers up to capacity signatures that were verified, the least recently used one is evicted first
+verify_cache *verify_cache_new(uint64_t capacity);
+void verify_cache_free(verify_cache *cache);
+void verify_cache_clear(verify_cache *cache);
+void verify_cache_get_stats(verify_cache *cache, verify_cache_stats *stats);
+
+// the key is the hash of the ring digest, the message hash and the hash of the signature, linkable signatures get a different key
+void verify_cache_key(const unsigned char *ring_digest, const unsigned char *message_hash, const unsigned char *sig, uint64_t sig_len, int linkable, unsigned char *key);
+// returns 1 if the key is in the cache (and marks it as recently used), 0 otherwise
+int verify_cache_lookup(verify_cache *cache, const unsigned char *key);
+void verify_cache_insert(verify_cache *cache, const unsigned char *key);
+
+// only valid signatures are cached, invalid ones are verified every time
+int rverify_cached(verify_cache *cache, const ring_ctx *ring, const unsigned char *m, uint64_t mlen, const unsigned char *sig, uint64_t sig_len, int threads);
+int lrverify_cached(verify_cache *cache, const ring_ctx *ring, const unsigned char *m, uint64_t mlen, const unsigned char *sig, uint64_t sig_len, int threads);
+
+#endif